@@ -1,444 +1,3606 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <limits.h>
-#define MAX_PROCESSES 100
+#include <math.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
+#include "sched.h"
+
+// Buffered output: callers fill a large buffer that is handed to fwrite
+// only when full, instead of going through stdio once per item
+typedef struct {
+    FILE *f;
+    char *buf;
+    size_t used;
+} Writer;
+
+#define CHART_BUFFER 4096
+
+// Where the Gantt charts of a run go. The library collects segments in buf
+// and chart_flush() writes them out as text, binary segments or both.
+typedef struct {
+    Gantt gantt;
+    GanttSegment *buf;
+    Writer text;
+    Writer segments;
+    int cpu_labels;     // Start each run's text chart with "CPU n: " (multi-core)
+} Chart;
+
+// ---------------------------------------------------------------------------
+// Statistics
+// ---------------------------------------------------------------------------
+
+void print_averages(const Stats *s) {
+    printf("\nAverage Waiting Time: %.2f\n", histogram_mean(&s->waiting));
+    printf("Average Turnaround Time: %.2f\n", histogram_mean(&s->turnaround));
+}
+
+void print_percentiles(const Stats *s) {
+    const Histogram *rows[3] = { &s->waiting, &s->turnaround, &s->response };
+    const char *names[3] = { "Waiting", "Turnaround", "Response" };
+
+    printf("\n%-12s%-12s%-12s%-12s%-12s%s\n", "Time", "Mean", "p50", "p95", "p99", "Max");
+    for (int r = 0; r < 3; r++) {
+        printf("%-12s%-12.2f%-12lld%-12lld%-12lld%lld\n", names[r], histogram_mean(rows[r]),
+               histogram_percentile(rows[r], 50), histogram_percentile(rows[r], 95),
+               histogram_percentile(rows[r], 99), rows[r]->max);
+    }
+
+    // Lateness is only known for processes with a deadline
+    long long deadlines = s->early.count + s->late.count;
+    if (deadlines > 0) {
+        printf("%-12s%-12.2f%-12lld%-12lld%-12lld%lld\n", "Lateness", lateness_mean(s),
+               lateness_percentile(s, 50), lateness_percentile(s, 95), lateness_percentile(s, 99),
+               s->late.count > 0 ? s->late.max : -s->early.min);
+        printf("\nDeadline misses: %lld of %lld (%.2f%%)\n", s->late.count, deadlines,
+               100.0 * (double)s->late.count / (double)deadlines);
+    }
+}
+
+// How busy the CPU and each device were over a run that ended at makespan,
+// and the throughput of its processes
+void print_io_usage(const IoUsage *usage, int devices, int processes, SimTime makespan) {
+    double span = makespan > 0 ? (double)makespan : 1;
+    printf("\nCPU utilization: %.2f%% (busy %lld of %lld)\n", 100.0 * (double)usage->cpu_busy / span,
+           usage->cpu_busy, makespan);
+    printf("Throughput: %.4f processes per time unit\n", (double)processes / span);
+
+    printf("\nDevice\tRequests\tBusy\tUtilization\tAvg Queue Wait\tMax Queue\n");
+    for (int d = 0; d < devices; d++) {
+        const DeviceStats *s = &usage->devices[d];
+        printf("%d\t%lld\t%lld\t%.2f%%\t%.2f\t%d\n", d, s->requests, s->busy, 100.0 * (double)s->busy / span,
+               s->requests > 0 ? (double)s->queued / (double)s->requests : 0.0, s->max_queue);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Instrumentation
+// ---------------------------------------------------------------------------
+
+// Write the used entries of metrics[count] with the time spent loading the
+// workload, as JSON if the path ends in .json and CSV otherwise. Report time
+// is for the whole run, as "all" prints its algorithms together. Returns 0
+// on success.
+int metrics_save(const char *path, const Metrics metrics[], int count, double load_seconds) {
+    double report_seconds = 0;
+    for (int i = 0; i < count; i++)
+        report_seconds += metrics[i].report_seconds;
+
+    size_t length = strlen(path);
+    int json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot create metrics file %s\n", path);
+        return -1;
+    }
+
+    if (json)
+        fprintf(f, "{\n  \"load_seconds\": %.6f,\n  \"report_seconds\": %.6f,\n  \"runs\": [",
+                load_seconds, report_seconds);
+    else
+        fprintf(f, "algorithm,load_seconds,simulate_seconds,report_seconds,dispatches,switches,preemptions,"
+                   "idle_jumps,idle_skipped,queue_pushes,queue_pops,select_steps\n");
+
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        const Metrics *r = &metrics[i];
+        if (r->algorithm[0] == '\0')
+            continue;
+        if (json) {
+            fprintf(f, "%s\n    {\"algorithm\": \"%s\", \"simulate_seconds\": %.6f, "
+                       "\"dispatches\": %lld, \"switches\": %lld, \"preemptions\": %lld, \"idle_jumps\": %lld, "
+                       "\"idle_skipped\": %lld, \"queue_pushes\": %lld, \"queue_pops\": %lld, \"select_steps\": %lld}",
+                    written > 0 ? "," : "", r->algorithm, r->simulate_seconds,
+                    r->dispatches, r->switches, r->preemptions, r->idle_jumps, (long long)r->idle_skipped,
+                    r->queue_pushes, r->queue_pops, r->select_steps);
+        } else {
+            fprintf(f, "%s,%.6f,%.6f,%.6f,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld\n", r->algorithm, load_seconds,
+                    r->simulate_seconds, report_seconds, r->dispatches, r->switches, r->preemptions,
+                    r->idle_jumps, (long long)r->idle_skipped, r->queue_pushes, r->queue_pops, r->select_steps);
+        }
+        written++;
+    }
+    if (json)
+        fprintf(f, "\n  ]\n}\n");
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Error writing metrics file %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Gantt chart
+// ---------------------------------------------------------------------------
+
+#define WRITER_BUFFER (1 << 20)
+#define GANTT_MAGIC "SCHEDGT1"
+
+void writer_open(Writer *w, FILE *f) {
+    w->f = f;
+    w->buf = f != NULL ? malloc(WRITER_BUFFER) : NULL;
+    w->used = 0;
+}
+
+void writer_flush(Writer *w) {
+    if (w->f != NULL && w->used > 0)
+        fwrite(w->buf, 1, w->used, w->f);
+    w->used = 0;
+}
+
+void writer_close(Writer *w) {
+    writer_flush(w);
+    free(w->buf);
+    w->buf = NULL;
+    w->f = NULL;
+}
+
+void writer_put(Writer *w, const void *data, size_t len) {
+    if (w->used + len > WRITER_BUFFER)
+        writer_flush(w);
+    memcpy(w->buf + w->used, data, len);
+    w->used += len;
+}
+
+// Decimal formatting without going through printf
+static void writer_put_num(Writer *w, long long value) {
+    char digits[24];
+    int len = 0;
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    do {
+        digits[sizeof(digits) - 1 - len++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (value < 0)
+        digits[sizeof(digits) - 1 - len++] = '-';
+
+    writer_put(w, digits + sizeof(digits) - len, (size_t)len);
+}
+
+// Write out the segments the library has collected, and finish the text
+// line at the end of a run
+static void chart_flush(Gantt *g, int end) {
+    Chart *c = g->ctx;
+
+    for (size_t i = 0; i < g->count; i++) {
+        const GanttSegment *s = &g->segments[i];
+        if (c->text.f != NULL && s->pid == 0 && c->cpu_labels) {
+            writer_put(&c->text, "CPU ", 4);
+            writer_put_num(&c->text, s->end);
+            writer_put(&c->text, ": ", 2);
+        } else if (c->text.f != NULL && s->pid != 0) {
+            writer_put(&c->text, "| P", 3);
+            writer_put_num(&c->text, s->pid);
+            writer_put(&c->text, " ", 1);
+            writer_put_num(&c->text, s->start);
+            writer_put(&c->text, "-", 1);
+            writer_put_num(&c->text, s->end);
+            writer_put(&c->text, " ", 1);
+        }
+        if (c->segments.f != NULL) {
+            int32_t record_pid = s->pid;
+            int64_t record_start = s->start, record_end = s->end;
+            writer_put(&c->segments, &record_pid, sizeof(record_pid));
+            writer_put(&c->segments, &record_start, sizeof(record_start));
+            writer_put(&c->segments, &record_end, sizeof(record_end));
+        }
+    }
+    g->count = 0;
+
+    if (end) {
+        if (c->text.f != NULL)
+            writer_put(&c->text, "|\n", 2);
+        writer_flush(&c->text);
+        writer_flush(&c->segments);
+    }
+}
+
+// text: chart printed as "| P1 0-5 | P2 5-9 |", segments: binary segment
+// file (starting with GANTT_MAGIC, written by the caller) holding every
+// segment, run markers included. Returns the Gantt to record into, or NULL
+// if both outputs are off so the engines can skip charting altogether.
+Gantt *chart_open(Chart *c, FILE *text, FILE *segments) {
+    writer_open(&c->text, text);
+    writer_open(&c->segments, segments);
+    c->cpu_labels = 0;
+    c->buf = text != NULL || segments != NULL ? malloc(sizeof(GanttSegment) * CHART_BUFFER) : NULL;
+    gantt_init(&c->gantt, c->buf, CHART_BUFFER, chart_flush, c);
+    return c->buf != NULL ? &c->gantt : NULL;
+}
+
+void chart_close(Chart *c) {
+    writer_close(&c->text);
+    writer_close(&c->segments);
+    free(c->buf);
+    c->buf = NULL;
+}
+
+// Copy charts spooled by another Chart (e.g. a worker thread) into this one
+// and close the spool files
+void chart_splice(Chart *c, FILE *text, FILE *segments) {
+    FILE *spools[2] = { text, segments };
+    Writer *writers[2] = { c != NULL ? &c->text : NULL, c != NULL ? &c->segments : NULL };
+    char chunk[65536];
+
+    for (int s = 0; s < 2; s++) {
+        if (spools[s] == NULL)
+            continue;
+        rewind(spools[s]);
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), spools[s])) > 0) {
+            if (writers[s] != NULL && writers[s]->f != NULL)
+                writer_put(writers[s], chunk, got);
+        }
+        if (writers[s] != NULL)
+            writer_flush(writers[s]);
+        fclose(spools[s]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Checkpoints
+// ---------------------------------------------------------------------------
+
+// A checkpoint file holds the magic, a CheckpointHeader, the remaining,
+// response and completion times of the `count` processes covered, then
+// `ready_count` ReadyEntry records, all in native byte order. Version 2
+// added `held`.
+#define CHECKPOINT_MAGIC "SCHEDCP2"
+
+void checkpoint_free(Checkpoint *cp) {
+    free(cp->remaining);
+    free(cp->response);
+    free(cp->completion);
+    free(cp->ready);
+}
+
+int checkpoint_load(const char *path, Checkpoint *cp) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open checkpoint %s\n", path);
+        return -1;
+    }
+
+    char magic[sizeof(CHECKPOINT_MAGIC) - 1];
+    CheckpointHeader *h = &cp->header;
+    int ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+             memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0 &&
+             fread(h, sizeof(*h), 1, f) == 1 &&
+             h->count >= 0 && h->next >= 0 && h->next <= h->count &&
+             h->ready_count >= 0 && h->ready_count <= h->next &&
+             (h->held == 0 || (h->held == 1 && h->ready_count > 0));
+
+    cp->remaining = NULL;
+    cp->response = NULL;
+    cp->completion = NULL;
+    cp->ready = NULL;
+    if (ok) {
+        size_t n = (size_t)h->count;
+        cp->remaining = malloc(sizeof(SimTime) * (n > 0 ? n : 1));
+        cp->response = malloc(sizeof(SimTime) * (n > 0 ? n : 1));
+        cp->completion = malloc(sizeof(SimTime) * (n > 0 ? n : 1));
+        cp->ready = malloc(sizeof(ReadyEntry) * (h->ready_count > 0 ? (size_t)h->ready_count : 1));
+        ok = fread(cp->remaining, sizeof(SimTime), n, f) == n &&
+             fread(cp->response, sizeof(SimTime), n, f) == n &&
+             fread(cp->completion, sizeof(SimTime), n, f) == n &&
+             fread(cp->ready, sizeof(ReadyEntry), (size_t)h->ready_count, f) == (size_t)h->ready_count;
+        for (int r = 0; ok && r < h->ready_count; r++)
+            ok = cp->ready[r].idx >= 0 && cp->ready[r].idx < h->count;
+    }
+    fclose(f);
+
+    if (!ok) {
+        fprintf(stderr, "Corrupt checkpoint %s\n", path);
+        checkpoint_free(cp);
+        return -1;
+    }
+    return 0;
+}
+
+// Check that a checkpoint can resume this run on this table
+int checkpoint_check(const Checkpoint *cp, const ProcessTable *t, uint64_t settings) {
+    const CheckpointHeader *h = &cp->header;
+
+    if (h->settings != settings) {
+        fprintf(stderr, "The checkpoint was taken with a different algorithm or parameters\n");
+        return -1;
+    }
+    if (h->count > t->count || checkpoint_fingerprint(t, h->count) != h->fingerprint) {
+        fprintf(stderr, "The trace does not start with the %d processes the checkpoint covers\n", h->count);
+        return -1;
+    }
+    for (int i = h->count; i < t->count; i++) {
+        if (t->arrival_time[i] < h->time) {
+            fprintf(stderr, "Process %d arrives at %lld, before the checkpoint at %lld\n",
+                    t->pid[i], (long long)t->arrival_time[i], (long long)h->time);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Write the checkpoint through a temporary file, so an interrupted write
+// leaves the previous one in place. cp->ctx is the path.
+void checkpoint_save(Checkpointer *cp, const ProcessTable *t, const CheckpointHeader *h, const ReadyEntry ready[]) {
+    const char *path = cp->ctx;
+    size_t length = strlen(path);
+    char *tmp = malloc(length + 5);
+    memcpy(tmp, path, length);
+    memcpy(tmp + length, ".tmp", 5);
+
+    FILE *f = fopen(tmp, "wb");
+    size_t n = (size_t)h->count;
+    int ok = f != NULL &&
+             fwrite(CHECKPOINT_MAGIC, 1, sizeof(CHECKPOINT_MAGIC) - 1, f) == sizeof(CHECKPOINT_MAGIC) - 1 &&
+             fwrite(h, sizeof(*h), 1, f) == 1 &&
+             fwrite(t->remaining_time, sizeof(SimTime), n, f) == n &&
+             fwrite(t->response_time, sizeof(SimTime), n, f) == n &&
+             fwrite(t->completion_time, sizeof(SimTime), n, f) == n &&
+             fwrite(ready, sizeof(ReadyEntry), (size_t)h->ready_count, f) == (size_t)h->ready_count;
+    if (f != NULL && fclose(f) != 0)
+        ok = 0;
+#ifdef _WIN32
+    if (ok)
+        remove(path);   // rename() won't replace an existing file here
+#endif
+    if (ok)
+        ok = rename(tmp, path) == 0;
+
+    if (!ok) {
+        fprintf(stderr, "Cannot write checkpoint %s\n", path);
+        remove(tmp);
+        cp->failed = 1;
+    }
+    free(tmp);
+}
+// ---------------------------------------------------------------------------
+// Algorithms
+// ---------------------------------------------------------------------------
+
+static const char *algorithm_names[] = { "FCFS", "SJF", "RR", "Priority", "SRT" };
+
+// Name of any single algorithm by menu number
+static const char *algorithm_name(int algorithm) {
+    switch (algorithm) {
+        case 7: return "Multilevel";
+        case 8: return "MLFQ";
+        case 9: return "CFS";
+        case 12: return "EDF";
+        case 13: return "RM";
+        default: return algorithm >= 1 && algorithm <= 5 ? algorithm_names[algorithm - 1] : "Unknown";
+    }
+}
+
+void print_results(const ProcessTable *t) {
+    printf("PID\tArrival\tBurst\tWaiting\tTurnaround\n");
+    for (int i = 0; i < t->count; i++) {
+        printf("%d\t%lld\t%lld\t%lld\t%lld\n", t->pid[i], t->arrival_time[i],
+               t->burst_time[i], t->waiting_time[i], t->turnaround_time[i]);
+    }
+}
+
+// Results table for one algorithm; Priority and CFS also show each process's
+// priority (the nice value for CFS), EDF and RM its absolute deadline, period
+// and lateness ("-" without a deadline)
+static void print_algorithm_results(const ProcessTable *t, int algorithm) {
+    if (algorithm == 4 || algorithm == 9) {
+        printf("PID\tArrival\tBurst\tPriority\tWaiting\tTurnaround\n");
+        for (int i = 0; i < t->count; i++) {
+            printf("%d\t%lld\t%lld\t%d\t%lld\t%lld\n", t->pid[i], t->arrival_time[i],
+                   t->burst_time[i], t->priority[i], t->waiting_time[i], t->turnaround_time[i]);
+        }
+    } else if (algorithm == 12 || algorithm == 13) {
+        printf("PID\tArrival\tBurst\tDeadline\tPeriod\tWaiting\tTurnaround\tLateness\n");
+        for (int i = 0; i < t->count; i++) {
+            printf("%d\t%lld\t%lld\t", t->pid[i], t->arrival_time[i], t->burst_time[i]);
+            if (t->deadline[i] > 0)
+                printf("%lld\t", t->arrival_time[i] + t->deadline[i]);
+            else
+                printf("-\t");
+            printf("%lld\t%lld\t%lld\t", t->period[i], t->waiting_time[i], t->turnaround_time[i]);
+            if (t->deadline[i] > 0)
+                printf("%lld\n", t->completion_time[i] - t->arrival_time[i] - t->deadline[i]);
+            else
+                printf("-\n");
+        }
+    } else {
+        print_results(t);
+    }
+}
+
+// Simulate config over the whole table through sched_run, into the table's
+// own result columns, and label the counters with name. Returns the time the
+// last process finished, or -1 if sched_run turned the run down.
+static SimTime run_table(ProcessTable *t, const SchedConfig *config, const char *name, Gantt *gantt,
+                         Stats *stats, CoreStats *usage, Metrics *metrics) {
+    SchedWorkload workload = { t->count, t->arrival_time, t->burst_time, t->priority, t->queue,
+                               t->deadline, t->period };
+    SchedResults results = { t->completion_time, t->waiting_time, t->turnaround_time, t->response_time,
+                             NULL, 0, 0, gantt, usage, stats, metrics, 0 };
+
+    if (sched_run(&workload, config, &results) != 0) {
+        fprintf(stderr, "Error: can't run %s on this workload\n", name);
+        return -1;
+    }
+    if (metrics != NULL)
+        snprintf(metrics->algorithm, sizeof(metrics->algorithm), "%s", name);
+    return results.makespan;
+}
+
+// Run one algorithm and print its chart, results and averages
+static void run_and_print(ProcessTable *t, int algorithm, int quantum, Gantt *gantt, Metrics *metrics) {
+    SchedConfig config = { 0 };
+    Stats stats;
+    config.algorithm = algorithm;
+    config.quantum = quantum;
+    config.threads = cpu_count();
+
+    printf("\n%s Results:\n", algorithm_name(algorithm));
+    if (run_table(t, &config, algorithm_name(algorithm), gantt, &stats, NULL, metrics) < 0)
+        return;
+
+    double start = 0;
+    METRIC(if (metrics != NULL) start = wall_clock());
+    print_algorithm_results(t, algorithm);
+    print_averages(&stats);
+    print_percentiles(&stats);
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
+}
+
+void fcfs(ProcessTable *t, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 1, 0, gantt, metrics);
+}
+
+void sjf(ProcessTable *t, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 2, 0, gantt, metrics);
+}
+
+void rr(ProcessTable *t, int quantum, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 3, quantum, gantt, metrics);
+}
+
+void priority(ProcessTable *t, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 4, 0, gantt, metrics);
+}
+
+void srt(ProcessTable *t, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 5, 0, gantt, metrics);
+}
+
+void edf(ProcessTable *t, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 12, 0, gantt, metrics);
+}
+
+void rm(ProcessTable *t, Gantt *gantt, Metrics *metrics) {
+    run_and_print(t, 13, 0, gantt, metrics);
+}
+
+void mlfq(ProcessTable *t, const FeedbackConfig *config, Gantt *gantt, Metrics *metrics) {
+    SchedConfig run = { 0 };
+    Stats stats;
+    run.algorithm = 8;
+    run.feedback = *config;
+
+    printf("\nMLFQ Results:\n");
+    if (run_table(t, &run, "MLFQ", gantt, &stats, NULL, metrics) < 0)
+        return;
+
+    double start = 0;
+    METRIC(if (metrics != NULL) start = wall_clock());
+    print_results(t);
+    print_averages(&stats);
+    print_percentiles(&stats);
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
+}
+
+void cfs(ProcessTable *t, const FairConfig *config, Gantt *gantt, Metrics *metrics) {
+    SchedConfig run = { 0 };
+    Stats stats;
+    run.algorithm = 9;
+    run.fair = *config;
+
+    printf("\nCFS Results:\n");
+    if (run_table(t, &run, "CFS", gantt, &stats, NULL, metrics) < 0)
+        return;
+
+    double start = 0;
+    METRIC(if (metrics != NULL) start = wall_clock());
+    print_algorithm_results(t, 9);
+    print_averages(&stats);
+    print_percentiles(&stats);
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
+}
+
+// Run algorithm 1-5, 8 (MLFQ) or 9 (CFS) over the whole table, resuming from
+// and writing checkpoints as cp says, and print it like the plain runs.
+// Returns nonzero if the checkpoint doesn't fit or couldn't be written, or
+// the run never came to a point to take one.
+int run_checkpointed(ProcessTable *t, int algorithm, int quantum, const FeedbackConfig *feedback,
+                     const FairConfig *fair, Checkpointer *cp, Gantt *gantt, Metrics *metrics) {
+    const char *name = algorithm_name(algorithm);
+    Stats stats;
+    stats_init(&stats);
+    if (metrics != NULL)
+        metrics_init(metrics, name);
+
+    if (cp->resume != NULL &&
+        checkpoint_check(cp->resume, t, checkpoint_settings(algorithm, quantum, feedback, fair)) != 0)
+        return 1;
+
+    printf("\n%s Results:\n", name);
+    gantt_begin(gantt, algorithm, 0);
+    run_resumable(t, algorithm, quantum, feedback, fair, cp, gantt, &stats, metrics);
+    gantt_end(gantt);
+
+    double start = 0;
+    METRIC(if (metrics != NULL) start = wall_clock());
+    print_algorithm_results(t, algorithm);
+    print_averages(&stats);
+    print_percentiles(&stats);
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
+    if (cp->save != NULL && !cp->failed && cp->saved == 0) {
+        fprintf(stderr, "No checkpoint was saved to %s: every process had arrived before the run began\n",
+                (const char *)cp->ctx);
+        return 1;
+    }
+    return cp->failed;
+}
+
+// One algorithm of "Run All", simulated on its own copy of the workload
+typedef struct {
+    int algorithm;
+    int quantum;
+    ProcessTable table;
+    Stats stats;
+    Metrics *metrics;   // NULL = none
+    FILE *chart;        // Gantt output spooled here, copied out in order afterwards
+    FILE *segments;
+    const IoWorkload *io;   // Shared read-only, NULL = CPU bursts only
+    IoUsage usage;
+    SimTime makespan;
+} AlgorithmRun;
+
+static void run_all_worker(void *ctx, int i) {
+    AlgorithmRun *run = &((AlgorithmRun *)ctx)[i];
+    Chart chart;
+    Gantt *gantt = chart_open(&chart, run->chart, run->segments);
+
+    gantt_begin(gantt, run->algorithm, 0);
+    stats_init(&run->stats);
+    if (run->io != NULL)
+        run->makespan = run_io(&run->table, run->io, run->algorithm, run->quantum, gantt, &run->stats,
+                               run->metrics, &run->usage);
+    else
+        run->makespan = run_algorithm(&run->table, run->algorithm, run->quantum, gantt, &run->stats, run->metrics,
+                                      0);
+    gantt_end(gantt);
+    chart_close(&chart);
+}
+
+// Run FCFS, SJF, RR, Priority and SRT in parallel, each on a private fork
+// of the table, then print them side by side, with the CPU utilization and
+// throughput of each when the processes block on io (NULL = they don't).
+// metrics, unless NULL, has room for one entry per algorithm.
+void run_all(ProcessTable *t, int quantum, Gantt *gantt, Metrics metrics[], const IoWorkload *io) {
+    enum { RUNS = 5 };
+    AlgorithmRun *runs = malloc(sizeof(AlgorithmRun) * RUNS);
+    Chart *chart = gantt != NULL ? gantt->ctx : NULL;
+
+    for (int r = 0; r < RUNS; r++) {
+        runs[r].algorithm = r + 1;
+        runs[r].quantum = quantum;
+        runs[r].io = io;
+        runs[r].metrics = metrics != NULL ? &metrics[r] : NULL;
+        if (metrics != NULL)
+            metrics_init(&metrics[r], algorithm_names[r]);
+        table_fork(&runs[r].table, t);
+        runs[r].chart = chart != NULL && chart->text.f != NULL ? tmpfile() : NULL;
+        runs[r].segments = chart != NULL && chart->segments.f != NULL ? tmpfile() : NULL;
+    }
+
+    parallel_for(RUNS, run_all_worker, runs);
+
+    // The algorithms are reported together; the time goes on the first
+    double start = 0;
+    METRIC(if (metrics != NULL) start = wall_clock());
+    printf("\n=== Run All Algorithms ===\n");
+    for (int r = 0; r < RUNS; r++) {
+        if (runs[r].chart != NULL)
+            printf("\n%s Gantt Chart:\n", algorithm_names[r]);
+        chart_splice(chart, runs[r].chart, runs[r].segments);
+    }
+
+    // Per-process comparison, each cell is waiting/turnaround
+    printf("\nPID\tArrival\tBurst\tPriority");
+    for (int r = 0; r < RUNS; r++)
+        printf("\t%s", algorithm_names[r]);
+    printf("\n");
+    for (int i = 0; i < t->count; i++) {
+        printf("%d\t%lld\t%lld\t%d", t->pid[i], t->arrival_time[i], t->burst_time[i], t->priority[i]);
+        for (int r = 0; r < RUNS; r++)
+            printf("\t%lld/%lld", runs[r].table.waiting_time[i], runs[r].table.turnaround_time[i]);
+        printf("\n");
+    }
+
+    if (io != NULL)
+        printf("\n%-12s%-16s%-16s%-16s%-16s%-12s%s\n", "Algorithm", "Avg Waiting", "Avg Turnaround",
+               "p95 Waiting", "p99 Waiting", "CPU Util", "Throughput");
+    else
+        printf("\n%-12s%-16s%-16s%-16s%s\n", "Algorithm", "Avg Waiting", "Avg Turnaround", "p95 Waiting", "p99 Waiting");
+    for (int r = 0; r < RUNS; r++) {
+        const Histogram *waiting = &runs[r].stats.waiting;
+        if (io != NULL) {
+            double span = runs[r].makespan > 0 ? (double)runs[r].makespan : 1;
+            char busy[32];
+            snprintf(busy, sizeof(busy), "%.2f%%", 100.0 * (double)runs[r].usage.cpu_busy / span);
+            printf("%-12s%-16.2f%-16.2f%-16lld%-16lld%-12s%.4f\n", algorithm_names[r], histogram_mean(waiting),
+                   histogram_mean(&runs[r].stats.turnaround), histogram_percentile(waiting, 95),
+                   histogram_percentile(waiting, 99), busy, (double)t->count / span);
+        } else {
+            printf("%-12s%-16.2f%-16.2f%-16lld%lld\n", algorithm_names[r], histogram_mean(waiting),
+                   histogram_mean(&runs[r].stats.turnaround), histogram_percentile(waiting, 95),
+                   histogram_percentile(waiting, 99));
+        }
+        table_free(&runs[r].table);
+    }
+    free(runs);
+    METRIC(if (metrics != NULL) metrics[0].report_seconds = wall_clock() - start);
+}
+
+void multilevel_queue(ProcessTable *t, Queue queues[], int num_queues, const int members[], Gantt *gantt,
+                      Metrics *metrics) {
+    SimTime current_time = 0;
+    Stats *overall = malloc(sizeof(Stats));
+    Stats *queue_stats = malloc(sizeof(Stats));
+    double start = 0;
+    stats_init(overall);
+    if (metrics != NULL)
+        metrics_init(metrics, "Multilevel");
+    METRIC(if (metrics != NULL) start = wall_clock());
+
+    printf("\n=== Multilevel Queue Scheduling ===\n");
+
+    // Process each queue in priority order (each queue completes before next one starts)
+    for (int q = 0; q < num_queues; q++) {
+        if (queues[q].process_count == 0) {
+            printf("\n--- Queue %d: Empty ---\n", q);
+            continue;
+        }
+
+        const int *order = &members[queues[q].first];
+        int queue_size = queues[q].process_count;
+
+        // Display queue header
+        printf("\n--- Queue %d ", q);
+        switch (queues[q].algorithm) {
+            case 1: printf("(FCFS)"); break;
+            case 2: printf("(SJF)"); break;
+            case 3: printf("(RR, q=%d)", queues[q].quantum); break;
+            case 4: printf("(Priority)"); break;
+        }
+        printf(" ---\n");
+
+        // Processes in this queue can't start before the queue becomes active
+        SimTime start_time = current_time;
+
+        stats_init(queue_stats);
+        current_time = run_queue(t, &queues[q], q, members, start_time, gantt, queue_stats, metrics);
+        stats_merge(overall, queue_stats);
+
+        // Display process details for this queue
+        printf("\nPID\tArrival\tBurst\tWaiting\tTurnaround\n");
+        for (int i = 0; i < queue_size; i++) {
+            int idx = order[i];
+            printf("%d\t%lld\t%lld\t%lld\t%lld\n",
+                   t->pid[idx],
+                   effective_arrival(t, idx, start_time),
+                   t->burst_time[idx],
+                   t->waiting_time[idx],
+                   t->turnaround_time[idx]);
+        }
+
+        printf("Average Waiting Time: %.2f\n", histogram_mean(&queue_stats->waiting));
+        printf("Average Turnaround Time: %.2f\n", histogram_mean(&queue_stats->turnaround));
+    }
+
+    // Display overall statistics, merged from every queue
+    printf("\n=== Overall Statistics ===\n");
+    print_averages(overall);
+    print_percentiles(overall);
+    free(queue_stats);
+    free(overall);
+    // Queues are printed as they finish, so reporting is whatever the engine didn't take
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start - metrics->simulate_seconds);
+}
+
+// ---------------------------------------------------------------------------
+// Periodic tasks
+// ---------------------------------------------------------------------------
+
+// Longest horizon taken by default; a longer hyperperiod needs one given
+#define HORIZON_LIMIT 1000000000000LL
+
+// Expand the periodic tasks of t into their jobs up to horizon (by default one
+// hyperperiod past the last task's first release) and print the task set's
+// utilization, against the EDF and RM bounds when it runs on one CPU.
+// Returns nonzero if the jobs can't be released.
+int release_tasks(ProcessTable *t, SimTime horizon, int cpus) {
+    int tasks;
+    double u = utilization(t, &tasks);
+    if (tasks == 0)
+        return 0;
+
+    // Density: the utilization test extended to deadlines shorter than periods
+    double density = 0;
+    int constrained = 0;
+    SimTime last = 0;
+    for (int i = 0; i < t->count; i++) {
+        if (t->period[i] <= 0)
+            continue;
+        constrained |= t->deadline[i] > 0 && t->deadline[i] < t->period[i];
+        SimTime window = t->deadline[i] > 0 && t->deadline[i] < t->period[i] ? t->deadline[i] : t->period[i];
+        density += (double)t->burst_time[i] / (double)window;
+        if (t->arrival_time[i] > last)
+            last = t->arrival_time[i];
+    }
+
+    if (horizon <= 0) {
+        SimTime h = hyperperiod(t, HORIZON_LIMIT);
+        if (h < 0 || last > HORIZON_LIMIT - h) {
+            fprintf(stderr, "The hyperperiod of the task set is over %lld; give a shorter horizon\n", HORIZON_LIMIT);
+            return 1;
+        }
+        horizon = last + h;
+    }
+    int jobs = release_jobs(t, horizon);
+    if (jobs < 0) {
+        fprintf(stderr, "Releasing jobs up to time %lld would make over %d processes\n", horizon, INT_MAX);
+        return 1;
+    }
+
+    // Both tests are sufficient only: past the Liu and Layland bound RM may
+    // still meet every deadline, and so may EDF past the density test. The
+    // RM bound assumes no deadline is shorter than its period.
+    double bound = rm_bound(tasks);
+    const char *edf_verdict = density <= 1 ? "yes" : u > 1 ? "no" : "not guaranteed";
+    const char *rm_verdict = u > 1 ? "no" : !constrained && u <= bound ? "yes" : "not guaranteed";
+    printf("\nPeriodic tasks: %d (%d jobs released before %lld)\n", tasks, tasks + jobs, horizon);
+    if (cpus > 1) {
+        printf("Utilization: %.4f on %d CPUs (density %.4f)\n", u, cpus, density);
+        return 0;
+    }
+    printf("Utilization: %.4f (density %.4f, EDF bound 1, RM bound %.4f)\n", u, density, bound);
+    printf("Schedulable: EDF %s, RM %s\n", edf_verdict, rm_verdict);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// I/O devices
+// ---------------------------------------------------------------------------
+
+// Results table of a run that blocks on I/O: Burst is a process's total CPU
+// time, I/O the service time of its requests and Waiting its time in the
+// ready queue, so time queued at devices is whatever is left of Turnaround
+static void print_io_results(const ProcessTable *t, const IoWorkload *io) {
+    printf("PID\tArrival\tBurst\tI/O\tWaiting\tTurnaround\n");
+    for (int i = 0; i < t->count; i++) {
+        SimTime service = 0;
+        for (int s = 0; s < io_count(io, i); s++) {
+            const IoStep *step = &io->steps[io->first[i] + s];
+            if (step->device >= 0)
+                service += step->time;
+        }
+        printf("%d\t%lld\t%lld\t%lld\t%lld\t%lld\n", t->pid[i], t->arrival_time[i], t->burst_time[i],
+               service, t->waiting_time[i], t->turnaround_time[i]);
+    }
+}
+
+// Run one of fcfs..srt over a workload that blocks on I/O and print its
+// chart, results, averages and CPU and device utilization
+void run_io_and_print(ProcessTable *t, const IoWorkload *io, int algorithm, int quantum, Gantt *gantt,
+                      Metrics *metrics) {
+    Stats stats;
+    IoUsage usage;
+    stats_init(&stats);
+    if (metrics != NULL)
+        metrics_init(metrics, algorithm_name(algorithm));
+
+    printf("\n%s Results:\n", algorithm_name(algorithm));
+    gantt_begin(gantt, algorithm, 0);
+    SimTime makespan = run_io(t, io, algorithm, quantum, gantt, &stats, metrics, &usage);
+    gantt_end(gantt);
+
+    double start = 0;
+    METRIC(if (metrics != NULL) start = wall_clock());
+    print_io_results(t, io);
+    print_averages(&stats);
+    print_percentiles(&stats);
+    print_io_usage(&usage, io->devices, t->count, makespan);
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
+}
+
+// ---------------------------------------------------------------------------
+// Parameter sweep
+// ---------------------------------------------------------------------------
+
+// One point of a sweep: RR with a quantum, or a multilevel queue set
+typedef struct {
+    int algorithm;      // 3=RR, 7=Multilevel
+    int quantum;
+    Queue *queues;
+    int num_queues;
+    char label[128];
+    double avg_waiting;
+    double avg_turnaround;
+    SimTime p99_waiting;
+    SimTime makespan;
+    double cpu_utilization; // With I/O: CPU busy time over the makespan
+    int index;          // Position before ranking, for stable ties
+} SweepConfig;
+
+typedef struct {
+    const ProcessTable *table;  // Shared read-only by every worker
+    SweepConfig *configs;
+    const IoWorkload *io;       // Likewise; NULL = CPU bursts only (RR configurations only otherwise)
+} Sweep;
+
+static void sweep_worker(void *ctx, int i) {
+    Sweep *sweep = ctx;
+    SweepConfig *c = &sweep->configs[i];
+    ProcessTable fork;
+    Stats *stats = malloc(sizeof(Stats));
+    table_fork(&fork, sweep->table);
+    stats_init(stats);
+
+    if (c->algorithm == 3 && sweep->io != NULL) {
+        IoUsage usage;
+        c->makespan = run_io(&fork, sweep->io, 3, c->quantum, NULL, stats, NULL, &usage);
+        c->cpu_utilization = c->makespan > 0 ? (double)usage.cpu_busy / (double)c->makespan : 0;
+    } else if (c->algorithm == 3) {
+        c->makespan = run_algorithm(&fork, 3, c->quantum, NULL, stats, NULL, 0);
+    } else {
+        int *members = malloc(sizeof(int) * (fork.count > 0 ? fork.count : 1));
+        group_by_queue(&fork, c->queues, c->num_queues, members);
+        c->makespan = run_multilevel(&fork, c->queues, c->num_queues, members, NULL, stats, NULL);
+        free(members);
+    }
+
+    c->avg_waiting = histogram_mean(&stats->waiting);
+    c->avg_turnaround = histogram_mean(&stats->turnaround);
+    c->p99_waiting = histogram_percentile(&stats->waiting, 99);
+    free(stats);
+    table_free(&fork);
+}
+
+static int sweep_rank(const void *a, const void *b) {
+    const SweepConfig *x = a, *y = b;
+    if (x->avg_waiting != y->avg_waiting)
+        return x->avg_waiting < y->avg_waiting ? -1 : 1;
+    if (x->avg_turnaround != y->avg_turnaround)
+        return x->avg_turnaround < y->avg_turnaround ? -1 : 1;
+    return x->index - y->index;
+}
+
+// Label a multilevel configuration the way --queues spells it
+static void queue_label(SweepConfig *c) {
+    static const char *names[] = { "fcfs", "sjf", "rr", "priority" };
+    size_t used = (size_t)snprintf(c->label, sizeof(c->label), "mlq ");
+
+    for (int q = 0; q < c->num_queues && used < sizeof(c->label); q++) {
+        const Queue *queue = &c->queues[q];
+        if (queue->algorithm == 3)
+            used += (size_t)snprintf(c->label + used, sizeof(c->label) - used, "%srr:%d", q ? "," : "", queue->quantum);
+        else
+            used += (size_t)snprintf(c->label + used, sizeof(c->label) - used, "%s%s", q ? "," : "", names[queue->algorithm - 1]);
+    }
+}
+
+// Evaluate every configuration in parallel over one workload and print a
+// ranked, tab-separated table (best average waiting time first). When the
+// processes block on io (NULL = they don't), which only RR configurations
+// support, the table also has CPU utilization and throughput.
+void run_sweep(const ProcessTable *t, SweepConfig configs[], int count, const IoWorkload *io) {
+    Sweep sweep = { t, configs, io };
+
+    for (int i = 0; i < count; i++)
+        configs[i].index = i;
+    parallel_for(count, sweep_worker, &sweep);
+    qsort(configs, (size_t)count, sizeof(SweepConfig), sweep_rank);
+
+    printf("rank\tconfig\tavg_waiting\tavg_turnaround\tp99_waiting\tmakespan%s\n",
+           io != NULL ? "\tcpu_utilization\tthroughput" : "");
+    for (int i = 0; i < count; i++) {
+        printf("%d\t%s\t%.4f\t%.4f\t%lld\t%lld", i + 1, configs[i].label,
+               configs[i].avg_waiting, configs[i].avg_turnaround, configs[i].p99_waiting,
+               configs[i].makespan);
+        if (io != NULL) {
+            printf("\t%.4f\t%.6f", configs[i].cpu_utilization,
+                   configs[i].makespan > 0 ? (double)t->count / (double)configs[i].makespan : 0.0);
+        }
+        printf("\n");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Multi-core simulation
+// ---------------------------------------------------------------------------
+
+// Run one algorithm on several cores and print per-core charts, results,
+// utilization and migrations
+void multicore(ProcessTable *t, int algorithm, int quantum, const SmpConfig *config, Gantt *gantt, Metrics *metrics) {
+    CoreStats *usage = malloc(sizeof(CoreStats) * config->cpus);
+    SchedConfig run = { 0 };
+    Stats stats;
+    long long migrations = 0;
+    double start = 0;
+
+    run.algorithm = algorithm;
+    run.quantum = quantum;
+    run.smp = *config;
+    printf("\n%s Results on %d CPUs:\n", algorithm_name(algorithm), config->cpus);
+    METRIC(if (metrics != NULL) start = wall_clock());
+    if (gantt != NULL)
+        ((Chart *)gantt->ctx)->cpu_labels = 1;
+    SimTime makespan = run_table(t, &run, algorithm_name(algorithm), gantt, &stats, usage, metrics);
+    if (gantt != NULL)
+        ((Chart *)gantt->ctx)->cpu_labels = 0;
+    if (makespan < 0) {
+        free(usage);
+        return;
+    }
+    METRIC(if (metrics != NULL) metrics->simulate_seconds = wall_clock() - start);
+    METRIC(if (metrics != NULL) start = wall_clock());
+    print_algorithm_results(t, algorithm);
+
+    printf("\nCPU\tBusy\tUtilization\tSlices\tMigrations\n");
+    for (int c = 0; c < config->cpus; c++) {
+        printf("%d\t%lld\t%.2f%%\t%lld\t%lld\n", c, usage[c].busy,
+               makespan > 0 ? 100.0 * usage[c].busy / makespan : 0.0, usage[c].slices, usage[c].migrations);
+        migrations += usage[c].migrations;
+    }
+
+    print_averages(&stats);
+    print_percentiles(&stats);
+    printf("Makespan: %lld\n", makespan);
+    printf("Migrations: %lld\n", migrations);
+    METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
+    free(usage);
+}
+
+// ---------------------------------------------------------------------------
+// Monte Carlo replications
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const GeneratorConfig *gen;
+    int choice;             // Menu choice 1-7
+    int quantum;
+    const Queue *queues;
+    int num_queues;
+    const FeedbackConfig *feedback;
+    const FairConfig *fair;
+    int runs;               // Algorithms per replication
+    double *waiting;        // [replication * runs + run]
+    double *turnaround;
+    Stats *pooled;          // [run], every process of every replication
+    pthread_mutex_t lock;   // Guards pooled
+} Replications;
+
+static void replication_worker(void *ctx, int r) {
+    Replications *reps = ctx;
+    ProcessTable t;
+    Stats *stats = malloc(sizeof(Stats));
+    table_init(&t);
+    generate_workload(&t, reps->gen, (uint64_t)r);
+
+    for (int k = 0; k < reps->runs; k++) {
+        stats_init(stats);
+        if (reps->choice == 7) {
+            Queue *queues = malloc(sizeof(Queue) * reps->num_queues);
+            int *members = malloc(sizeof(int) * t.count);
+            memcpy(queues, reps->queues, sizeof(Queue) * reps->num_queues);
+            group_by_queue(&t, queues, reps->num_queues, members);
+            run_multilevel(&t, queues, reps->num_queues, members, NULL, stats, NULL);
+            free(members);
+            free(queues);
+        } else if (reps->choice == 8) {
+            run_feedback(&t, reps->feedback, NULL, stats, NULL);
+        } else if (reps->choice == 9) {
+            run_fair(&t, reps->fair, NULL, stats, NULL);
+        } else {
+            int algorithm = reps->choice == 6 ? k + 1 : reps->choice;
+            run_algorithm(&t, algorithm, reps->quantum, NULL, stats, NULL, 0);
+        }
+        reps->waiting[r * reps->runs + k] = histogram_mean(&stats->waiting);
+        reps->turnaround[r * reps->runs + k] = histogram_mean(&stats->turnaround);
+
+        pthread_mutex_lock(&reps->lock);
+        stats_merge(&reps->pooled[k], stats);
+        pthread_mutex_unlock(&reps->lock);
+    }
+
+    free(stats);
+    table_free(&t);
+}
+
+// Two-sided 95% Student t critical value for df degrees of freedom
+static double t_critical(int df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1)
+        return 0;
+    return df <= 30 ? table[df - 1] : 1.96;
+}
+
+// Mean and 95% confidence half-width of values[k], values[k + stride], ...
+static void mean_ci(const double values[], int count, int stride, double *mean, double *half_width) {
+    double sum = 0, sum_sq = 0;
+
+    for (int i = 0; i < count; i++)
+        sum += values[i * stride];
+    *mean = sum / count;
+    for (int i = 0; i < count; i++) {
+        double d = values[i * stride] - *mean;
+        sum_sq += d * d;
+    }
+    *half_width = count > 1 ? t_critical(count - 1) * sqrt(sum_sq / (count - 1) / count) : 0;
+}
+
+// Simulate `count` independently generated workloads in parallel and print
+// the mean of each algorithm's average waiting and turnaround time with a
+// 95% confidence interval, plus tail percentiles over every simulated process
+void run_replications(const GeneratorConfig *gen, int count, int choice, int quantum,
+                      const Queue queues[], int num_queues, const FeedbackConfig *feedback, const FairConfig *fair) {
+    static const char *names[] = { "FCFS", "SJF", "RR", "Priority", "SRT", "All", "Multilevel", "MLFQ", "CFS" };
+    Replications reps = { gen, choice, quantum, queues, num_queues, feedback, fair, choice == 6 ? 5 : 1, NULL, NULL, NULL, PTHREAD_MUTEX_INITIALIZER };
+
+    reps.waiting = malloc(sizeof(double) * count * reps.runs);
+    reps.turnaround = malloc(sizeof(double) * count * reps.runs);
+    reps.pooled = malloc(sizeof(Stats) * reps.runs);
+    for (int k = 0; k < reps.runs; k++)
+        stats_init(&reps.pooled[k]);
+    parallel_for(count, replication_worker, &reps);
+    pthread_mutex_destroy(&reps.lock);
+
+    printf("replications\t%d\tprocesses\t%d\tseed\t%llu\n", count, gen->count, (unsigned long long)gen->seed);
+    printf("algorithm\tavg_waiting\tci95_waiting\tavg_turnaround\tci95_turnaround\t"
+           "p50_waiting\tp95_waiting\tp99_waiting\tp99_response\n");
+    for (int k = 0; k < reps.runs; k++) {
+        double waiting, waiting_ci, turnaround, turnaround_ci;
+        const Stats *pooled = &reps.pooled[k];
+        mean_ci(reps.waiting + k, count, reps.runs, &waiting, &waiting_ci);
+        mean_ci(reps.turnaround + k, count, reps.runs, &turnaround, &turnaround_ci);
+        printf("%s\t%.4f\t%.4f\t%.4f\t%.4f\t%lld\t%lld\t%lld\t%lld\n", names[choice == 6 ? k : choice - 1],
+               waiting, waiting_ci, turnaround, turnaround_ci,
+               histogram_percentile(&pooled->waiting, 50), histogram_percentile(&pooled->waiting, 95),
+               histogram_percentile(&pooled->waiting, 99), histogram_percentile(&pooled->response, 99));
+    }
+
+    free(reps.waiting);
+    free(reps.turnaround);
+    free(reps.pooled);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+// Short runs are repeated until they add up to BENCH_MIN_SECONDS so small
+// workloads aren't lost in timer noise; the fastest run is reported
+#define BENCH_MIN_SECONDS 0.2
+#define BENCH_MAX_RUNS 100000
+
+typedef struct {
+    char algorithm[16];
+    int n;
+    int runs;
+    double wall_ms;         // Fastest run
+    long long events;       // Arrivals plus dispatched slices
+    double events_per_sec;
+    long peak_kib;          // Peak resident memory of the run's process, see bench_isolated()
+} BenchResult;
+
+#ifndef _WIN32
+static long rusage_kib(const struct rusage *usage) {
+#ifdef __APPLE__
+    return usage->ru_maxrss / 1024;     // Bytes on macOS
+#else
+    return usage->ru_maxrss;            // KiB on Linux and the BSDs
+#endif
+}
+#endif
+
+// Peak resident memory of this process so far. It never goes down, so it
+// only says something about the largest run yet.
+long peak_memory_kib(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return rusage_kib(&usage);
+#endif
+}
+
+// Time one algorithm (1-5, 8 for MLFQ or 9 for CFS) over forks of the
+// workload. Setup and teardown are outside the timed region; sorting by
+// arrival is part of every run.
+static void bench_algorithm(const ProcessTable *t, int algorithm, int quantum, const FeedbackConfig *feedback,
+                            const FairConfig *fair, BenchResult *r) {
+    double total = 0;
+
+    snprintf(r->algorithm, sizeof(r->algorithm), "%s", algorithm_name(algorithm));
+    r->n = t->count;
+    r->runs = 0;
+    do {
+        ProcessTable fork;
+        double start, elapsed;
+        long long dispatches;
+        table_fork(&fork, t);
+
+        if (algorithm == 8) {
+            FeedbackQueue fq;
+            feedback_init(&fq, fork.count, feedback, NULL);
+            start = wall_clock();
+            simulate_feedback(&fork, &fq);
+            elapsed = wall_clock() - start;
+            dispatches = fq.dispatches;
+            feedback_free(&fq);
+        } else if (algorithm == 9) {
+            FairQueue fq;
+            fair_init(&fq, fork.count, fair, NULL);
+            start = wall_clock();
+            simulate_fair(&fork, &fq);
+            elapsed = wall_clock() - start;
+            dispatches = fq.dispatches;
+            fair_free(&fq);
+        } else {
+            ReadyQueue rq;
+            Policy policy;
+            policy_init(&policy, &rq, &fork, fork.count, algorithm, quantum, NULL);
+            policy.threads = cpu_count();
+            start = wall_clock();
+            simulate_all(&fork, &policy);
+            elapsed = wall_clock() - start;
+            dispatches = policy.dispatches;
+            ready_free(&rq);
+        }
+        table_free(&fork);
+
+        if (r->runs == 0 || elapsed * 1000 < r->wall_ms)
+            r->wall_ms = elapsed * 1000;
+        r->events = t->count + dispatches;
+        total += elapsed;
+        r->runs++;
+    } while (total < BENCH_MIN_SECONDS && r->runs < BENCH_MAX_RUNS);
+
+    r->events_per_sec = r->wall_ms > 0 ? r->events / (r->wall_ms / 1000) : 0;
+}
+
+// Benchmark one algorithm in a child process of its own, whose peak memory
+// starts from the workload alone: peak_kib is then what this algorithm
+// needs, whatever ran before it. Returns 1 if it was measured that way, or 0
+// if peak_kib is only this process's peak so far (on Windows, or if the
+// child couldn't be started or failed).
+static int bench_isolated(const ProcessTable *t, int algorithm, int quantum, const FeedbackConfig *feedback,
+                          const FairConfig *fair, BenchResult *r) {
+#ifndef _WIN32
+    int fds[2];
+    if (pipe(fds) == 0) {
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            close(fds[0]);
+            bench_algorithm(t, algorithm, quantum, feedback, fair, r);
+            _exit(write(fds[1], r, sizeof(*r)) == (ssize_t)sizeof(*r) ? 0 : 1);
+        }
+        close(fds[1]);
+
+        // The result is far smaller than PIPE_BUF, so it arrives whole or not at all
+        ssize_t got = child > 0 ? read(fds[0], r, sizeof(*r)) : -1;
+        close(fds[0]);
+        if (child > 0) {
+            struct rusage usage;
+            int status;
+            if (wait4(child, &status, 0, &usage) == child && got == (ssize_t)sizeof(*r) &&
+                WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                r->peak_kib = rusage_kib(&usage);
+                return 1;
+            }
+        }
+    }
+#endif
+    bench_algorithm(t, algorithm, quantum, feedback, fair, r);
+    r->peak_kib = peak_memory_kib();
+    return 0;
+}
+
+static void print_bench_row(FILE *f, const BenchResult *r) {
+    fprintf(f, "%s\t%d\t%d\t%.3f\t%lld\t%.0f\t%ld", r->algorithm, r->n, r->runs,
+            r->wall_ms, r->events, r->events_per_sec, r->peak_kib);
+}
+
+// Read a baseline saved by --save-baseline. Returns the number of rows, or
+// -1 if the file can't be opened.
+static int load_baseline(const char *path, BenchResult **rows) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    int count = 0;
+
+    *rows = NULL;
+    if (f == NULL)
+        return -1;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        BenchResult r;
+        if (sscanf(line, "%15s\t%d\t%d\t%lf\t%lld\t%lf\t%ld", r.algorithm, &r.n, &r.runs,
+                   &r.wall_ms, &r.events, &r.events_per_sec, &r.peak_kib) != 7)
+            continue;   // Header or malformed row
+        *rows = realloc(*rows, sizeof(BenchResult) * (count + 1));
+        (*rows)[count++] = r;
+    }
+
+    fclose(f);
+    return count;
+}
+
+static const BenchResult *find_baseline(const BenchResult rows[], int count, const BenchResult *r) {
+    for (int i = 0; i < count; i++) {
+        if (rows[i].n == r->n && strcmp(rows[i].algorithm, r->algorithm) == 0)
+            return &rows[i];
+    }
+    return NULL;
+}
+
+// Run FCFS, SJF, RR, Priority, SRT, MLFQ and CFS on generated workloads of 1e3, 1e4, ...
+// up to max_n processes and print a tab-separated table. A row regresses when
+// its throughput drops, or its peak memory grows, by more than threshold
+// percent against the baseline; memory is only compared when each algorithm
+// ran in a process of its own. Returns the number of regressions.
+int run_benchmark(const GeneratorConfig *gen, int max_n, int quantum, const FeedbackConfig *feedback,
+                  const FairConfig *fair, const char *baseline_path, const char *save_path, double threshold) {
+    static const int algorithms[] = { 1, 2, 3, 4, 5, 8, 9 };
+    BenchResult *baseline = NULL;
+    int baseline_count = -1;
+    FILE *save = NULL;
+    int regressions = 0;
+
+    if (baseline_path != NULL) {
+        baseline_count = load_baseline(baseline_path, &baseline);
+        if (baseline_count < 0)
+            fprintf(stderr, "No baseline at %s, nothing to compare against\n", baseline_path);
+    }
+    if (save_path != NULL) {
+        save = fopen(save_path, "w");
+        if (save == NULL) {
+            fprintf(stderr, "Cannot create baseline file %s\n", save_path);
+            free(baseline);
+            return 1;
+        }
+        fprintf(save, "algorithm\tn\truns\twall_ms\tevents\tevents_per_sec\tpeak_kib\n");
+    }
+
+    printf("algorithm\tn\truns\twall_ms\tevents\tevents_per_sec\tpeak_kib\tvs_baseline\tstatus\n");
+    for (long long n = 1000; n <= max_n; n *= 10) {
+        GeneratorConfig g = *gen;
+        ProcessTable t;
+        g.count = (int)n;
+        table_init(&t);
+        generate_workload(&t, &g, 0);
+
+        for (int a = 0; a < (int)(sizeof(algorithms) / sizeof(algorithms[0])); a++) {
+            BenchResult r;
+            int isolated = bench_isolated(&t, algorithms[a], quantum, feedback, fair, &r);
+
+            print_bench_row(stdout, &r);
+            const BenchResult *base = baseline_count > 0 ? find_baseline(baseline, baseline_count, &r) : NULL;
+            if (base == NULL) {
+                printf("\t-\t%s\n", baseline_count >= 0 ? "new" : "-");
+            } else if (base->events != r.events) {
+                // Different generator options or quantum: not comparable
+                printf("\t-\tworkload differs\n");
+            } else {
+                double change = (r.events_per_sec / base->events_per_sec - 1) * 100;
+                int slower = change < -threshold;
+                int bigger = isolated && r.peak_kib > base->peak_kib * (1 + threshold / 100);
+                printf("\t%+.1f%%\t%s\n", change, slower ? "REGRESSED" : bigger ? "REGRESSED (memory)" : "ok");
+                regressions += slower || bigger;
+            }
+            fflush(stdout);
+
+            if (save != NULL) {
+                print_bench_row(save, &r);
+                fprintf(save, "\n");
+            }
+        }
+
+        table_free(&t);
+    }
+
+    if (save != NULL && fclose(save) != 0) {
+        fprintf(stderr, "Error writing baseline file %s\n", save_path);
+        regressions++;
+    }
+    if (regressions > 0)
+        fprintf(stderr, "%d benchmark(s) regressed by more than %.1f%%\n", regressions, threshold);
+
+    free(baseline);
+    return regressions;
+}
+
+// ---------------------------------------------------------------------------
+// Trace files
+// ---------------------------------------------------------------------------
+
+// Binary trace: the magic, a uint64 record count, then packed records in
+// native byte order. SCHEDTR1 records stop after the queue; SCHEDTR2 ones
+// also hold deadline and period, and are only written when a process has
+// either. CSV traces hold "arrival,burst[,priority[,queue[,deadline[,period]]]]"
+// per line; blank lines, '#' comments and a header row are skipped. A burst
+// written CPU/DEVICE:SERVICE/CPU/... also blocks on I/O devices between its
+// CPU bursts; binary traces can't hold those. Text whose first line has a
+// bracketed CPU is read as a kernel trace instead.
+#define TRACE_MAGIC "SCHEDTR1"
+#define TRACE_MAGIC_RT "SCHEDTR2"
+#define TRACE_CHUNK (1 << 20)
+
+typedef struct {
+    int64_t arrival_time;
+    int64_t burst_time;
+    int32_t priority;
+    int32_t queue;
+    int64_t deadline;
+    int64_t period;
+} TraceRecord;
+
+#define TRACE_RECORD_V1 offsetof(TraceRecord, deadline)
+
+// Kernel scheduler traces: the text of ftrace (trace or trace_pipe with the
+// sched_switch and sched_wakeup events) or of perf script on a perf sched
+// record, in either the key=value or perf's compact field layout. Each
+// process read from one is a CPU burst of a task: it arrives when the task
+// wakes up and ends when the task next switches out without staying
+// runnable, and its burst is the CPU time it got in between. Times are
+// microseconds from the first event. Priorities are the kernel's minus 120,
+// i.e. nice values for normal tasks and below -20 for real-time ones, which
+// go to queue 0 and everything else to queue 1.
+typedef struct {
+    int pid;                // 0 = free slot
+    int prio;
+    int running;
+    int open;               // Woken up and not blocked since: in a burst
+    SimTime arrival;
+    SimTime first_run;      // -1 until the burst first runs
+    SimTime run_start;
+    SimTime ran;
+} KernelTask;
+
+typedef struct {
+    KernelTask *tasks;      // Open-addressing hash table on pid
+    int capacity;           // Power of two, at most half full
+    int count;
+    int cpus;               // Highest CPU seen, plus one
+    SimTime origin;         // Timestamp of the first event, -1 until then
+    SimTime last;           // Of the latest event
+    long long bursts;
+    long long unfinished;   // Bursts still open at the end of the trace
+    long long skipped;      // Lines that couldn't be parsed
+    int drain;              // Next slot to check for open bursts at the end
+    Stats observed;         // What the traced machine did, for bursts that ended
+} KernelTrace;
+
+typedef struct {
+    FILE *f;
+    int binary;
+    size_t record_size; // Binary: bytes per record in the file
+    uint64_t count;     // Binary: records in the trace
+    uint64_t left;      // Binary: records not read from the file yet
+    char *buf;
+    size_t pos;         // Next unread byte (CSV) or record (binary) in buf
+    size_t have;        // Bytes or records in buf
+    int eof;
+    int line_no;
+    int sniffed;            // Text: whether the first data line was seen
+    KernelTrace *kernel;    // Text: a kernel trace being imported, or NULL
+    IoStep *steps;          // CSV: bursts of the last process, if it does I/O
+    int step_count;         // 0 for a single CPU burst
+    int step_capacity;
+    int devices;            // CSV: highest device seen, plus one
+} TraceReader;
+
+// Parse the digits at *p into *value and move *p past them. Returns -1 if
+// the number doesn't fit a SimTime.
+static int parse_digits(const char **p, const char *end, SimTime *value) {
+    const char *q = *p;
+    *value = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        int digit = *q++ - '0';
+        if (*value > (LLONG_MAX - digit) / 10)
+            return -1;
+        *value = *value * 10 + digit;
+    }
+    *p = q;
+    return 0;
+}
+
+// Parse up to max comma/space separated integers from [p, end). Returns how
+// many, -1 if one is malformed or -2 if one is out of range.
+static int parse_fields(const char *p, const char *end, SimTime fields[], int max) {
+    int count = 0;
+
+    while (count < max) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+            p++;
+        if (p == end || *p == '\r')
+            break;
+
+        int negative = 0;
+        if (*p == '-') {
+            negative = 1;
+            p++;
+        }
+        if (p == end || *p < '0' || *p > '9')
+            return -1;
+
+        SimTime value;
+        if (parse_digits(&p, end, &value) != 0)
+            return -2;
+        fields[count++] = negative ? -value : value;
+    }
+
+    return count;
+}
+
+// Parse a burst field of the form CPU/DEVICE:SERVICE/CPU/... into r->steps,
+// with its total CPU time in *burst. Returns -1 if it is malformed or -2 if
+// a time or the total is out of range.
+static int parse_io_steps(TraceReader *r, const char *p, const char *end, SimTime *burst) {
+    *burst = 0;
+    r->step_count = 0;
+
+    for (;;) {
+        if (r->step_count + 2 > r->step_capacity) {
+            r->step_capacity = r->step_capacity > 0 ? r->step_capacity * 2 : 16;
+            r->steps = realloc(r->steps, sizeof(IoStep) * r->step_capacity);
+        }
+
+        // A CPU burst, then a request unless this was the last one
+        IoStep *cpu = &r->steps[r->step_count++];
+        cpu->device = -1;
+        cpu->time = 0;
+        if (p == end || *p < '0' || *p > '9')
+            return -1;
+        if (parse_digits(&p, end, &cpu->time) != 0 || cpu->time > LLONG_MAX - *burst)
+            return -2;
+        *burst += cpu->time;
+        if (p == end)
+            return r->step_count > 1 ? 0 : -1;
+        if (*p++ != '/')
+            return -1;
+
+        IoStep *request = &r->steps[r->step_count++];
+        request->device = 0;
+        request->time = 0;
+        if (p == end || *p < '0' || *p > '9')
+            return -1;
+        while (p < end && *p >= '0' && *p <= '9' && request->device < IO_MAX_DEVICES)
+            request->device = request->device * 10 + (*p++ - '0');
+        if (request->device >= IO_MAX_DEVICES || p == end || *p++ != ':' || p == end || *p < '0' || *p > '9')
+            return -1;
+        if (parse_digits(&p, end, &request->time) != 0)
+            return -2;
+        if (p == end || *p++ != '/')
+            return -1;
+        if (request->device + 1 > r->devices)
+            r->devices = request->device + 1;
+    }
+}
+
+static int is_separator(char c) {
+    return c == ',' || c == ' ' || c == '\t';
+}
+
+// Parse one CSV line into record, and any I/O bursts into r->steps. Returns
+// 1 for a process, 0 for a skipped line or -1 on error.
+static int parse_csv_line(TraceReader *r, const char *p, const char *end, TraceRecord *record) {
+    int line_no = r->line_no;
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if (p == end || *p == '\r' || *p == '#')
+        return 0;
+    if (line_no == 1 && !(*p == '-' || (*p >= '0' && *p <= '9')))
+        return 0;   // Header row
+
+    // A burst with I/O is parsed on its own, and the fields around it as usual
+    const char *burst = p, *burst_end;
+    while (burst < end && !is_separator(*burst))
+        burst++;
+    while (burst < end && is_separator(*burst))
+        burst++;
+    for (burst_end = burst; burst_end < end && !is_separator(*burst_end) && *burst_end != '\r'; burst_end++)
+        ;
+
+    SimTime fields[6];
+    int count, steps;
+    r->step_count = 0;
+    if (memchr(burst, '/', (size_t)(burst_end - burst)) == NULL) {
+        count = parse_fields(p, end, fields, 6);
+    } else if ((count = parse_fields(p, burst, fields, 1)) != 1) {
+        count = count < 0 ? count : -1;
+    } else if ((steps = parse_io_steps(r, burst, burst_end, &fields[1])) != 0) {
+        count = steps;
+    } else {
+        count = parse_fields(burst_end, end, fields + 2, 4);
+        count = count < 0 ? count : count + 2;
+    }
+    if (count == -2 || (count > 2 && (fields[2] < INT32_MIN || fields[2] > INT32_MAX)) ||
+        (count > 3 && (fields[3] < INT32_MIN || fields[3] > INT32_MAX))) {
+        fprintf(stderr, "Trace line %d: a field is out of range (times up to %lld, priority and queue "
+                        "%ld to %ld)\n", line_no, LLONG_MAX, (long)INT32_MIN, (long)INT32_MAX);
+        return -1;
+    }
+    if (count < 2 || fields[0] < 0 || fields[1] < 0 ||
+        (count > 4 && fields[4] < 0) || (count > 5 && fields[5] < 0)) {
+        fprintf(stderr, "Trace line %d: expected arrival,burst[,priority[,queue[,deadline[,period]]]]\n"
+                        "with burst a number or CPU/DEVICE:SERVICE/CPU/... (devices 0-%d)\n",
+                line_no, IO_MAX_DEVICES - 1);
+        return -1;
+    }
+
+    record->arrival_time = fields[0];
+    record->burst_time = fields[1];
+    record->priority = count > 2 ? (int32_t)fields[2] : 0;
+    record->queue = count > 3 ? (int32_t)fields[3] : 0;
+    record->deadline = count > 4 ? fields[4] : 0;
+    record->period = count > 5 ? fields[5] : 0;
+    return 1;
+}
+
+// Whether the first data line of a text trace is a kernel trace event: those
+// have the CPU in brackets, which CSV never does. -1 for a blank or comment
+// line, which can't tell.
+static int kernel_trace_sniff(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if (p == end || *p == '\r' || *p == '#')
+        return -1;
+    return memchr(p, ']', (size_t)(end - p)) != NULL;
+}
+
+static KernelTrace *kernel_trace_open(void) {
+    KernelTrace *k = malloc(sizeof(KernelTrace));
+    k->capacity = 1024;
+    k->tasks = calloc((size_t)k->capacity, sizeof(KernelTask));
+    k->count = 0;
+    k->cpus = 0;
+    k->origin = -1;
+    k->last = 0;
+    k->bursts = 0;
+    k->unfinished = 0;
+    k->skipped = 0;
+    k->drain = 0;
+    stats_init(&k->observed);
+    return k;
+}
+
+static void kernel_trace_close(KernelTrace *k) {
+    if (k == NULL)
+        return;
+    free(k->tasks);
+    free(k);
+}
+
+static KernelTask *kernel_slot(KernelTask tasks[], int capacity, int pid) {
+    unsigned h = ((unsigned)pid * 2654435761u) & (unsigned)(capacity - 1);
+    while (tasks[h].pid != 0 && tasks[h].pid != pid)
+        h = (h + 1) & (unsigned)(capacity - 1);
+    return &tasks[h];
+}
+
+// Find or add a task. Pointers into the table last until the next call.
+static KernelTask *kernel_task(KernelTrace *k, int pid) {
+    if (2 * (k->count + 1) > k->capacity) {
+        int capacity = k->capacity * 2;
+        KernelTask *tasks = calloc((size_t)capacity, sizeof(KernelTask));
+        for (int i = 0; i < k->capacity; i++) {
+            if (k->tasks[i].pid != 0)
+                *kernel_slot(tasks, capacity, k->tasks[i].pid) = k->tasks[i];
+        }
+        free(k->tasks);
+        k->tasks = tasks;
+        k->capacity = capacity;
+    }
+
+    KernelTask *task = kernel_slot(k->tasks, k->capacity, pid);
+    if (task->pid == 0) {
+        task->pid = pid;
+        task->prio = 120;
+        k->count++;
+    }
+    return task;
+}
+
+// Start a burst at time now unless the task is in one already
+static void kernel_open_burst(KernelTask *task, SimTime now) {
+    if (task->open)
+        return;
+    task->open = 1;
+    task->arrival = now;
+    task->first_run = -1;
+    task->ran = 0;
+}
+
+// Turn a task's burst into a process. Bursts are whole microseconds and
+// never empty.
+static void kernel_emit(KernelTrace *k, KernelTask *task, TraceRecord *record) {
+    record->arrival_time = task->arrival;
+    record->burst_time = task->ran > 0 ? task->ran : 1;
+    record->priority = task->prio - 120;
+    record->queue = task->prio < 100 ? 0 : 1;
+    record->deadline = 0;
+    record->period = 0;
+    task->open = 0;
+    k->bursts++;
+}
+
+// Find key in [p, end); returns the first byte after it, or NULL
+static const char *find_text(const char *p, const char *end, const char *key) {
+    size_t len = strlen(key);
+    while ((size_t)(end - p) >= len) {
+        const char *hit = memchr(p, key[0], (size_t)(end - p) - len + 1);
+        if (hit == NULL)
+            return NULL;
+        if (memcmp(hit, key, len) == 0)
+            return hit + len;
+        p = hit + 1;
+    }
+    return NULL;
+}
+
+// Parse a non-negative integer at p. Returns the byte after it, or NULL if
+// there are no digits.
+static const char *parse_number(const char *p, const char *end, long long *value) {
+    const char *start = p;
+    *value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        *value = *value * 10 + (*p++ - '0');
+    return p > start ? p : NULL;
+}
+
+// Integer value of key=N in [p, end)
+static int key_number(const char *p, const char *end, const char *key, long long *value) {
+    p = find_text(p, end, key);
+    return p != NULL && parse_number(p, end, value) != NULL;
+}
+
+// perf's compact "comm:pid [prio]", from the last " [" in [p, end). Sets
+// *after to the byte after the ']'.
+static int compact_task(const char *p, const char *end, long long *pid, long long *prio, const char **after) {
+    const char *bracket = NULL;
+    for (const char *q = p; (q = find_text(q, end, " [")) != NULL; )
+        bracket = q;
+    if (bracket == NULL)
+        return 0;
+
+    const char *digits = bracket - 2;
+    while (digits > p && digits[-1] >= '0' && digits[-1] <= '9')
+        digits--;
+    const char *close = parse_number(bracket, end, prio);
+    if (close == NULL || close == end || *close != ']' || parse_number(digits, bracket - 1, pid) == NULL)
+        return 0;
+    *after = close + 1;
+    return 1;
+}
+
+static void kernel_wakeup(KernelTrace *k, int pid, int prio, SimTime now) {
+    if (pid == 0)
+        return;
+    KernelTask *task = kernel_task(k, pid);
+    task->prio = prio;
+    kernel_open_burst(task, now);
+}
+
+// One CPU switching from prev to next. Returns 1 if prev's burst ended and
+// went into record.
+static int kernel_switch(KernelTrace *k, int prev, int prev_prio, int prev_runnable, int next, int next_prio,
+                         SimTime now, TraceRecord *record) {
+    int emitted = 0;
+
+    if (prev != 0) {
+        KernelTask *task = kernel_task(k, prev);
+        task->prio = prev_prio;
+        if (task->running)
+            task->ran += now - task->run_start;
+        task->running = 0;
+
+        // Preempted tasks stay runnable and carry on with the same burst. A
+        // task already running when the trace began has no burst to end.
+        if (!prev_runnable && task->open && task->first_run >= 0) {
+            SimTime turnaround = now - task->arrival;
+            histogram_add(&k->observed.turnaround, turnaround);
+            histogram_add(&k->observed.waiting, turnaround - task->ran);
+            histogram_add(&k->observed.response, task->first_run - task->arrival);
+            kernel_emit(k, task, record);
+            emitted = 1;
+        }
+    }
+    if (next != 0) {
+        KernelTask *task = kernel_task(k, next);
+        task->prio = next_prio;
+        kernel_open_burst(task, now);   // Running before the trace saw it wake up
+        if (task->first_run < 0)
+            task->first_run = now;
+        task->running = 1;
+        task->run_start = now;
+    }
+    return emitted;
+}
+
+// Parse one line: "TASK-PID [CPU] [FLAGS] SECONDS.FRACTION: EVENT: FIELDS"
+// from ftrace or "COMM PID [CPU] SECONDS.FRACTION: sched:EVENT: FIELDS" from
+// perf. Returns 1 if a burst ended and went into record, 0 otherwise.
+// Other events are ignored; sched events that don't parse are counted.
+static int kernel_trace_line(KernelTrace *k, const char *p, const char *end, TraceRecord *record) {
+    if (kernel_trace_sniff(p, end) < 0)
+        return 0;
+
+    // The CPU is the first bracketed number
+    long long cpu = -1;
+    const char *q = p;
+    while ((q = memchr(q, '[', (size_t)(end - q))) != NULL) {
+        const char *close = parse_number(++q, end, &cpu);
+        if (close != NULL && close < end && *close == ']') {
+            q = close + 1;
+            break;
+        }
+        cpu = -1;
+    }
+    if (cpu < 0) {
+        k->skipped++;
+        return 0;
+    }
+
+    // The timestamp is the first token after it that ends in ':', after any flags
+    long long seconds = 0, fraction = 0;
+    const char *event = NULL;
+    for (int token = 0; token < 3 && event == NULL; token++) {
+        while (q < end && *q == ' ')
+            q++;
+        const char *dot = parse_number(q, end, &seconds);
+        if (dot != NULL && dot < end && *dot == '.') {
+            const char *colon = parse_number(dot + 1, end, &fraction);
+            if (colon != NULL && colon < end && *colon == ':') {
+                // Keep microseconds whatever the precision
+                for (long long digits = colon - dot - 1; digits < 6; digits++)
+                    fraction *= 10;
+                for (long long digits = colon - dot - 1; digits > 6; digits--)
+                    fraction /= 10;
+                event = colon + 1;
+                break;
+            }
+        }
+        while (q < end && *q != ' ')
+            q++;
+    }
+    if (event == NULL) {
+        k->skipped++;
+        return 0;
+    }
+
+    while (event < end && *event == ' ')
+        event++;
+    if (end - event > 6 && memcmp(event, "sched:", 6) == 0)
+        event += 6;
+    int is_switch = end - event >= 13 && memcmp(event, "sched_switch:", 13) == 0;
+    int is_wakeup = (end - event >= 13 && memcmp(event, "sched_wakeup:", 13) == 0) ||
+                    (end - event >= 17 && memcmp(event, "sched_wakeup_new:", 17) == 0);
+    if (!is_switch && !is_wakeup)
+        return 0;
+    const char *fields = (const char *)memchr(event, ':', (size_t)(end - event)) + 1;
+
+    SimTime now = seconds * 1000000 + fraction;
+    if (k->origin < 0)
+        k->origin = now;
+    now -= k->origin;
+    if (now > k->last)
+        k->last = now;
+    if (cpu + 1 > k->cpus)
+        k->cpus = (int)cpu + 1;
+
+    long long pid, prio;
+    if (is_wakeup) {
+        const char *after;
+        if (key_number(fields, end, " pid=", &pid) && key_number(fields, end, " prio=", &prio)) {
+            kernel_wakeup(k, (int)pid, (int)prio, now);
+        } else if (compact_task(fields, end, &pid, &prio, &after)) {
+            kernel_wakeup(k, (int)pid, (int)prio, now);
+        } else {
+            k->skipped++;
+        }
+        return 0;
+    }
+
+    // prev's fields come before the arrow and next's after it
+    const char *next_fields = find_text(fields, end, " ==> ");
+    long long next, next_prio;
+    const char *state;
+    if (next_fields == NULL) {
+        k->skipped++;
+        return 0;
+    }
+    const char *arrow = next_fields - 5;
+    if (key_number(fields, arrow, "prev_pid=", &pid) && key_number(fields, arrow, "prev_prio=", &prio) &&
+        (state = find_text(fields, arrow, "prev_state=")) != NULL &&
+        key_number(next_fields, end, "next_pid=", &next) && key_number(next_fields, end, "next_prio=", &next_prio)) {
+        // ftrace's keyed fields
+    } else if (compact_task(fields, arrow, &pid, &prio, &state) &&
+               compact_task(next_fields, end, &next, &next_prio, &q)) {
+        while (state < arrow && *state == ' ')
+            state++;
+    } else {
+        k->skipped++;
+        return 0;
+    }
+    return kernel_switch(k, (int)pid, (int)prio, *state == 'R', (int)next, (int)next_prio, now, record);
+}
+
+// After the last line: the bursts still open that got some CPU, cut off at
+// the last event. They don't count towards the observed statistics.
+static int kernel_trace_drain(KernelTrace *k, TraceRecord *record) {
+    while (k->drain < k->capacity) {
+        KernelTask *task = &k->tasks[k->drain++];
+        if (task->pid == 0 || !task->open)
+            continue;
+        if (task->running)
+            task->ran += k->last - task->run_start;
+        if (task->ran > 0) {
+            kernel_emit(k, task, record);
+            k->unfinished++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// What was read and how the traced machine did
+static void kernel_trace_report(const KernelTrace *k) {
+    printf("Kernel trace: %lld CPU bursts of %d tasks on %d CPUs (%lld still running at the end), "
+           "%lld lines skipped\n", k->bursts, k->count, k->cpus, k->unfinished, k->skipped);
+    if (k->observed.waiting.count > 0) {
+        printf("\nObserved Results:\n");
+        print_averages(&k->observed);
+        print_percentiles(&k->observed);
+    }
+}
+
+void trace_close(TraceReader *r) {
+    if (r->f != NULL && r->f != stdin)
+        fclose(r->f);
+    free(r->buf);
+    free(r->steps);
+    kernel_trace_close(r->kernel);
+    r->f = NULL;
+    r->buf = NULL;
+    r->steps = NULL;
+    r->kernel = NULL;
+}
+
+// Open a trace for reading one process at a time through a fixed buffer.
+// The format is told by the magic without seeking back, so "-" reads a
+// trace piped to stdin.
+int trace_open(TraceReader *r, const char *path) {
+    r->f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (r->f == NULL) {
+        fprintf(stderr, "Cannot open trace file %s\n", path);
+        return -1;
+    }
+    r->buf = malloc(TRACE_CHUNK);
+    r->pos = 0;
+    r->have = fread(r->buf, 1, sizeof(TRACE_MAGIC) - 1, r->f);
+    r->eof = 0;
+    r->line_no = 0;
+    r->sniffed = 0;
+    r->kernel = NULL;
+    r->steps = NULL;
+    r->step_count = 0;
+    r->step_capacity = 0;
+    r->devices = 0;
+    r->binary = r->have == sizeof(TRACE_MAGIC) - 1 &&
+                (memcmp(r->buf, TRACE_MAGIC, r->have) == 0 || memcmp(r->buf, TRACE_MAGIC_RT, r->have) == 0);
+    r->record_size = r->binary && memcmp(r->buf, TRACE_MAGIC, r->have) == 0 ? TRACE_RECORD_V1 : sizeof(TraceRecord);
+    r->count = 0;
+    r->left = 0;
+
+    if (r->binary) {
+        r->have = 0;
+        if (fread(&r->count, sizeof(r->count), 1, r->f) != 1 || r->count > INT_MAX) {
+            fprintf(stderr, "Corrupt binary trace header\n");
+            trace_close(r);
+            return -1;
+        }
+        r->left = r->count;
+    }
+    return 0;
+}
+
+static int trace_next_binary(TraceReader *r, TraceRecord *record) {
+    if (r->pos == r->have) {
+        size_t batch = TRACE_CHUNK / r->record_size;
+        size_t want = r->left < batch ? (size_t)r->left : batch;
+        if (want == 0)
+            return 0;
+
+        size_t got = fread(r->buf, r->record_size, want, r->f);
+        r->left -= got;
+        if (got < want) {
+            fprintf(stderr, "Binary trace truncated after %llu of %llu records\n",
+                    (unsigned long long)(r->count - r->left), (unsigned long long)r->count);
+            return -1;
+        }
+        r->pos = 0;
+        r->have = got;
+    }
+
+    memset(record, 0, sizeof(*record));
+    memcpy(record, r->buf + r->pos++ * r->record_size, r->record_size);
+
+    // The same rules as a CSV line
+    if (record->arrival_time < 0 || record->burst_time < 0 || record->deadline < 0 || record->period < 0) {
+        fprintf(stderr, "Binary trace record %llu: arrival, burst, deadline and period must not be negative\n",
+                (unsigned long long)(r->count - r->left - (r->have - r->pos)));
+        return -1;
+    }
+    return 1;
+}
+
+static int trace_next_csv(TraceReader *r, TraceRecord *record) {
+    for (;;) {
+        char *p = r->buf + r->pos, *end = r->buf + r->have;
+        char *nl = memchr(p, '\n', (size_t)(end - p));
+
+        if (nl == NULL && !r->eof) {
+            // Partial line: move it to the front and read the next chunk
+            r->have -= r->pos;
+            memmove(r->buf, p, r->have);
+            r->pos = 0;
+            if (r->have == TRACE_CHUNK) {
+                fprintf(stderr, "Trace line %d is too long\n", r->line_no + 1);
+                return -1;
+            }
+            size_t got = fread(r->buf + r->have, 1, TRACE_CHUNK - r->have, r->f);
+            r->eof = got == 0;
+            r->have += got;
+            continue;
+        }
+        if (p == end)
+            return r->kernel != NULL ? kernel_trace_drain(r->kernel, record) : 0;
+        if (nl == NULL)
+            nl = end;
+
+        r->pos = (size_t)(nl - r->buf) + (nl < end);
+        r->line_no++;
+        if (!r->sniffed) {
+            int kernel = kernel_trace_sniff(p, nl);
+            r->sniffed = kernel >= 0;
+            if (kernel > 0)
+                r->kernel = kernel_trace_open();
+        }
+        int status = r->kernel != NULL ? kernel_trace_line(r->kernel, p, nl, record)
+                                       : parse_csv_line(r, p, nl, record);
+        if (status != 0)
+            return status;
+    }
+}
+
+// Read the next process. Returns 1 if there was one, 0 at the end of the
+// trace or -1 on error.
+int trace_next(TraceReader *r, TraceRecord *record) {
+    return r->binary ? trace_next_binary(r, record) : trace_next_csv(r, record);
+}
+
+// Load a CSV or binary trace into the table, with the bursts of processes
+// that do I/O into io
+int load_trace(const char *path, ProcessTable *t, IoWorkload *io) {
+    TraceReader r;
+    TraceRecord record;
+    int status;
+
+    if (trace_open(&r, path) != 0)
+        return -1;
+    if (r.binary)
+        table_reserve(t, t->count + (int)r.count);
+
+    while ((status = trace_next(&r, &record)) > 0) {
+        int i = table_add(t, record.arrival_time, record.burst_time, record.priority);
+        t->queue[i] = record.queue;
+        t->deadline[i] = record.deadline;
+        t->period[i] = record.period;
+        if (r.step_count > 0)
+            io_set(io, i, r.steps, r.step_count);
+    }
+
+    if (r.devices > io->devices)
+        io->devices = r.devices;
+    if (status == 0 && r.kernel != NULL)
+        kernel_trace_report(r.kernel);
+    trace_close(&r);
+    return status;
+}
+
+// Save the table as a binary trace
+int save_trace(const char *path, const ProcessTable *t) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot create trace file %s\n", path);
+        return -1;
+    }
+
+    size_t record_size = TRACE_RECORD_V1;
+    for (int i = 0; i < t->count && record_size == TRACE_RECORD_V1; i++) {
+        if (t->deadline[i] != 0 || t->period[i] != 0)
+            record_size = sizeof(TraceRecord);
+    }
+
+    uint64_t count = (uint64_t)t->count;
+    fwrite(record_size == TRACE_RECORD_V1 ? TRACE_MAGIC : TRACE_MAGIC_RT, 1, sizeof(TRACE_MAGIC) - 1, f);
+    fwrite(&count, sizeof(count), 1, f);
+
+    enum { BATCH = 65536 };
+    char *records = malloc(sizeof(TraceRecord) * BATCH);
+    for (int i = 0; i < t->count; i += BATCH) {
+        int m = t->count - i < BATCH ? t->count - i : BATCH;
+        for (int r = 0; r < m; r++) {
+            TraceRecord record;
+            record.arrival_time = t->arrival_time[i + r];
+            record.burst_time = t->burst_time[i + r];
+            record.priority = t->priority[i + r];
+            record.queue = t->queue[i + r];
+            record.deadline = t->deadline[i + r];
+            record.period = t->period[i + r];
+            memcpy(records + r * record_size, &record, record_size);
+        }
+        fwrite(records, record_size, (size_t)m, f);
+    }
+    free(records);
+
+    int status = ferror(f) ? -1 : 0;
+    if (fclose(f) != 0 || status != 0) {
+        fprintf(stderr, "Error writing trace file %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Run one menu choice (1-9, 12 = EDF or 13 = RM) on the loaded workload, with
+// FCFS..SRT, EDF and RM on several cores if smp asks for more than one.
+// Returns 1 for an invalid choice.
+int run_choice(ProcessTable *table, int choice, int quantum, Queue queues[], int num_queues, const int members[],
+               const FeedbackConfig *feedback, const FairConfig *fair, const SmpConfig *smp, Gantt *gantt,
+               Metrics metrics[]) {
+    if (smp != NULL && smp->cpus > 1 && ((choice >= 1 && choice <= 5) || choice == 12 || choice == 13)) {
+        multicore(table, choice, quantum, smp, gantt, metrics);
+        return 0;
+    }
+
+    switch (choice) {
+        case 1:
+            fcfs(table, gantt, metrics);
+            break;
+        case 2:
+            sjf(table, gantt, metrics);
+            break;
+        case 3:
+            rr(table, quantum, gantt, metrics);
+            break;
+        case 4:
+            priority(table, gantt, metrics);
+            break;
+        case 5:
+            srt(table, gantt, metrics);
+            break;
+        case 6:
+            run_all(table, quantum, gantt, metrics, NULL);
+            break;
+        case 7:
+            multilevel_queue(table, queues, num_queues, members, gantt, metrics);
+            break;
+        case 8:
+            mlfq(table, feedback, gantt, metrics);
+            break;
+        case 9:
+            cfs(table, fair, gantt, metrics);
+            break;
+        case 12:
+            edf(table, gantt, metrics);
+            break;
+        case 13:
+            rm(table, gantt, metrics);
+            break;
+        default:
+            return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Results files
+// ---------------------------------------------------------------------------
+
+// Results file: the magic, a ResultsHeader, one ResultsColumn per column,
+// then the column data, each padded to 8 bytes. Process columns are in table
+// order and segment columns in chart order, without the run markers. A raw
+// column is packed native-endian values that a reader can use straight from
+// the mapping; a delta column stores each value as the zigzag varint of its
+// difference from the one before, which takes sorted times down to a byte
+// or two.
+#define RESULTS_MAGIC "SCHEDRS1"
+#define GANTT_RECORD (sizeof(int32_t) + 2 * sizeof(int64_t))
+
+enum {
+    RESULTS_PID, RESULTS_ARRIVAL, RESULTS_BURST, RESULTS_PRIORITY, RESULTS_COMPLETION,
+    RESULTS_WAITING, RESULTS_TURNAROUND, RESULTS_RESPONSE,
+    RESULTS_SEGMENT_PID, RESULTS_SEGMENT_START, RESULTS_SEGMENT_END, RESULTS_SEGMENT_LANE,
+    RESULTS_COLUMNS
+};
+
+enum { RESULTS_RAW, RESULTS_DELTA };
+
+static const char *results_names[RESULTS_COLUMNS] = {
+    "pid", "arrival", "burst", "priority", "completion", "waiting", "turnaround", "response",
+    "segment_pid", "segment_start", "segment_end", "segment_lane"
+};
+
+static const int results_widths[RESULTS_COLUMNS] = { 4, 8, 8, 4, 8, 8, 8, 8, 4, 8, 8, 4 };
+
+typedef struct {
+    int32_t algorithm;      // Menu number
+    int32_t columns;        // Entries in the column directory
+    uint64_t processes;
+    uint64_t segments;
+} ResultsHeader;
+
+typedef struct {
+    uint32_t width;         // Bytes per value when raw
+    uint32_t encoding;
+    uint64_t offset;        // From the start of the file
+    uint64_t bytes;         // Without padding
+} ResultsColumn;
+
+// Append one value to a column. Returns the number of bytes written.
+static size_t results_put(Writer *w, int64_t value, int width, int encoding, int64_t *previous) {
+    if (encoding == RESULTS_RAW) {
+        int32_t narrow = (int32_t)value;
+        writer_put(w, width == 4 ? (const void *)&narrow : (const void *)&value, (size_t)width);
+        return (size_t)width;
+    }
+
+    uint64_t delta = (uint64_t)value - (uint64_t)*previous;
+    uint64_t zigzag = (delta << 1) ^ (0 - (delta >> 63));
+    unsigned char bytes[10];
+    size_t len = 0;
+
+    *previous = value;
+    while (zigzag >= 0x80) {
+        bytes[len++] = (unsigned char)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    bytes[len++] = (unsigned char)zigzag;
+    writer_put(w, bytes, len);
+    return len;
+}
+
+static int64_t process_value(const ProcessTable *t, int column, int i) {
+    switch (column) {
+        case RESULTS_PID: return t->pid[i];
+        case RESULTS_ARRIVAL: return t->arrival_time[i];
+        case RESULTS_BURST: return t->burst_time[i];
+        case RESULTS_PRIORITY: return t->priority[i];
+        case RESULTS_COMPLETION: return t->completion_time[i];
+        case RESULTS_WAITING: return t->waiting_time[i];
+        case RESULTS_TURNAROUND: return t->turnaround_time[i];
+        default: return t->response_time[i];
+    }
+}
+
+// Append one segment column, read back from a Gantt segment file. Markers
+// are dropped but give the lane (queue level or CPU) of the segments after
+// them. Returns the number of bytes written.
+static uint64_t results_put_segments(Writer *w, FILE *segments, int column, int encoding, uint64_t *count) {
+    enum { BATCH = 4096 };
+    unsigned char *records = malloc(GANTT_RECORD * BATCH);
+    int64_t previous = 0, lane = 0;
+    uint64_t bytes = 0;
+    size_t got;
+
+    *count = 0;
+    fseek(segments, (long)(sizeof(GANTT_MAGIC) - 1), SEEK_SET);
+    while ((got = fread(records, GANTT_RECORD, BATCH, segments)) > 0) {
+        for (size_t r = 0; r < got; r++) {
+            const unsigned char *record = records + r * GANTT_RECORD;
+            int32_t pid;
+            int64_t start, end;
+            memcpy(&pid, record, sizeof(pid));
+            memcpy(&start, record + sizeof(pid), sizeof(start));
+            memcpy(&end, record + sizeof(pid) + sizeof(start), sizeof(end));
+            if (pid == 0) {
+                lane = end;
+                continue;
+            }
+
+            int64_t value = column == RESULTS_SEGMENT_PID ? pid : column == RESULTS_SEGMENT_START ? start :
+                            column == RESULTS_SEGMENT_END ? end : lane;
+            bytes += results_put(w, value, results_widths[column], encoding, &previous);
+            (*count)++;
+        }
+    }
+
+    free(records);
+    return bytes;
+}
+
+// Save the results of the run just simulated on t, with its chart taken
+// from segments (a Gantt segment file open for reading)
+int results_save(const char *path, const ProcessTable *t, int algorithm, FILE *segments, int encoding) {
+    static const char padding[8] = { 0 };
+    ResultsHeader header = { algorithm, RESULTS_COLUMNS, (uint64_t)t->count, 0 };
+    ResultsColumn columns[RESULTS_COLUMNS];
+    uint64_t offset = sizeof(RESULTS_MAGIC) - 1 + sizeof(header) + sizeof(columns);
+    Writer w;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot create results file %s\n", path);
+        return -1;
+    }
+
+    // The directory is written again once the column sizes are known
+    memset(columns, 0, sizeof(columns));
+    fwrite(RESULTS_MAGIC, 1, sizeof(RESULTS_MAGIC) - 1, f);
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(columns, sizeof(columns), 1, f);
+
+    writer_open(&w, f);
+    for (int c = 0; c < RESULTS_COLUMNS; c++) {
+        uint64_t bytes = 0;
+        int64_t previous = 0;
+
+        if (c < RESULTS_SEGMENT_PID) {
+            for (int i = 0; i < t->count; i++)
+                bytes += results_put(&w, process_value(t, c, i), results_widths[c], encoding, &previous);
+        } else {
+            bytes = results_put_segments(&w, segments, c, encoding, &header.segments);
+        }
+
+        columns[c].width = (uint32_t)results_widths[c];
+        columns[c].encoding = (uint32_t)encoding;
+        columns[c].offset = offset;
+        columns[c].bytes = bytes;
+        writer_put(&w, padding, (size_t)(-bytes & 7));
+        offset += (bytes + 7) & ~(uint64_t)7;
+    }
+    writer_close(&w);
+
+    fseek(f, (long)(sizeof(RESULTS_MAGIC) - 1), SEEK_SET);
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(columns, sizeof(columns), 1, f);
+
+    int status = ferror(f) || ferror(segments) ? -1 : 0;
+    if (fclose(f) != 0 || status != 0) {
+        fprintf(stderr, "Error writing results file %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Read-only view of a whole file
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} MappedFile;
+
+static int map_file(const char *path, MappedFile *m) {
+    m->data = NULL;
+    m->size = 0;
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    m->mapping = NULL;
+    m->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                          FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m->file, &size))
+        return -1;
+    m->size = (size_t)size.QuadPart;
+    if (m->size == 0)
+        return 0;
+    m->mapping = CreateFileMappingA(m->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m->mapping == NULL)
+        return -1;
+    m->data = MapViewOfFile(m->mapping, FILE_MAP_READ, 0, 0, 0);
+    return m->data != NULL ? 0 : -1;
+#else
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    m->size = (size_t)st.st_size;
+    if (m->size > 0) {
+        void *data = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(data, m->size, MADV_SEQUENTIAL);
+        m->data = data;
+    }
+    close(fd);
+    return 0;
+#endif
+}
+
+static void unmap_file(MappedFile *m) {
+#ifdef _WIN32
+    if (m->data != NULL)
+        UnmapViewOfFile(m->data);
+    if (m->mapping != NULL)
+        CloseHandle(m->mapping);
+    if (m->file != INVALID_HANDLE_VALUE)
+        CloseHandle(m->file);
+#else
+    if (m->data != NULL)
+        munmap((void *)m->data, m->size);
+#endif
+    m->data = NULL;
+}
+
+// A results file mapped for reading. Columns are streamed through cursors
+// straight from the mapping, so nothing is loaded up front.
+typedef struct {
+    MappedFile map;
+    ResultsHeader header;
+    ResultsColumn columns[RESULTS_COLUMNS];
+} Results;
 
 typedef struct {
-    int pid;
-    int arrival_time;
-    int burst_time;
-    int priority;
-    int waiting_time;
-    int turnaround_time;
-    int remaining_time;
-    int completion_time;
-} Process;
+    const unsigned char *p;
+    const unsigned char *end;
+    int width;
+    int encoding;
+    int64_t previous;
+    int corrupt;        // A delta column ran out before its values did
+} ColumnCursor;
+
+static int results_open(const char *path, Results *r) {
+    size_t start = sizeof(RESULTS_MAGIC) - 1 + sizeof(ResultsHeader);
+
+    if (map_file(path, &r->map) != 0) {
+        fprintf(stderr, "Cannot map results file %s\n", path);
+        unmap_file(&r->map);
+        return -1;
+    }
+
+    int valid = r->map.size >= start && memcmp(r->map.data, RESULTS_MAGIC, sizeof(RESULTS_MAGIC) - 1) == 0;
+    if (valid) {
+        memcpy(&r->header, r->map.data + sizeof(RESULTS_MAGIC) - 1, sizeof(r->header));
+        valid = r->header.columns >= RESULTS_COLUMNS && r->header.processes <= INT_MAX &&
+                (r->map.size - start) / sizeof(ResultsColumn) >= (size_t)r->header.columns;
+    }
+    if (valid)
+        memcpy(r->columns, r->map.data + start, sizeof(r->columns));
+
+    // Later versions may add columns after the ones known here
+    for (int c = 0; valid && c < RESULTS_COLUMNS; c++) {
+        const ResultsColumn *column = &r->columns[c];
+        uint64_t count = c < RESULTS_SEGMENT_PID ? r->header.processes : r->header.segments;
+        valid = column->width == (uint32_t)results_widths[c] && column->offset % 8 == 0 &&
+                column->offset <= r->map.size && column->bytes <= r->map.size - column->offset &&
+                (column->encoding == RESULTS_DELTA ||
+                 (column->encoding == RESULTS_RAW && column->bytes / column->width == count &&
+                  column->bytes % column->width == 0));
+    }
+
+    if (!valid) {
+        fprintf(stderr, "%s is not a results file or is corrupt\n", path);
+        unmap_file(&r->map);
+        return -1;
+    }
+    return 0;
+}
+
+static void results_close(Results *r) {
+    unmap_file(&r->map);
+}
+
+static void cursor_init(ColumnCursor *c, const Results *r, int column) {
+    c->p = r->map.data + r->columns[column].offset;
+    c->end = c->p + r->columns[column].bytes;
+    c->width = (int)r->columns[column].width;
+    c->encoding = (int)r->columns[column].encoding;
+    c->previous = 0;
+    c->corrupt = 0;
+}
+
+// Next value of the column. Raw columns were checked to hold every value.
+static int64_t cursor_next(ColumnCursor *c) {
+    if (c->encoding == RESULTS_RAW) {
+        int64_t value = c->width == 4 ? *(const int32_t *)c->p : *(const int64_t *)c->p;
+        c->p += c->width;
+        return value;
+    }
+
+    uint64_t zigzag = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (c->p == c->end || shift > 63) {
+            c->corrupt = 1;
+            return 0;
+        }
+        unsigned char byte = *c->p++;
+        zigzag |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80)
+            break;
+    }
+    c->previous = (int64_t)((uint64_t)c->previous + ((zigzag >> 1) ^ (0 - (zigzag & 1))));
+    return c->previous;
+}
+
+// Completion statistics and makespan of a results file, streamed from its
+// mapping. Returns nonzero if a column turned out to be corrupt.
+static int results_aggregate(const Results *r, Stats *stats, SimTime *makespan) {
+    ColumnCursor completion, waiting, turnaround, response;
+    cursor_init(&completion, r, RESULTS_COMPLETION);
+    cursor_init(&waiting, r, RESULTS_WAITING);
+    cursor_init(&turnaround, r, RESULTS_TURNAROUND);
+    cursor_init(&response, r, RESULTS_RESPONSE);
+
+    stats_init(stats);
+    *makespan = 0;
+    for (uint64_t i = 0; i < r->header.processes; i++) {
+        SimTime end = cursor_next(&completion);
+        if (end > *makespan)
+            *makespan = end;
+        histogram_add(&stats->waiting, cursor_next(&waiting));
+        histogram_add(&stats->turnaround, cursor_next(&turnaround));
+        histogram_add(&stats->response, cursor_next(&response));
+    }
+    return completion.corrupt | waiting.corrupt | turnaround.corrupt | response.corrupt;
+}
+
+// Print what a results file holds: its columns, then the usual averages and
+// percentiles. Returns nonzero on error.
+int results_report(const char *path) {
+    Results r;
+    Stats *stats = malloc(sizeof(Stats));
+    SimTime makespan;
+
+    if (results_open(path, &r) != 0) {
+        free(stats);
+        return 1;
+    }
+    int corrupt = results_aggregate(&r, stats, &makespan);
+    if (corrupt) {
+        fprintf(stderr, "%s is not a results file or is corrupt\n", path);
+    } else {
+        printf("%s Results from %s:\n", algorithm_name(r.header.algorithm), path);
+        printf("Processes: %llu\n", (unsigned long long)r.header.processes);
+        printf("Segments: %llu\n", (unsigned long long)r.header.segments);
+        printf("Makespan: %lld\n", makespan);
+
+        printf("\nColumn\tEncoding\tBytes\n");
+        for (int c = 0; c < RESULTS_COLUMNS; c++) {
+            printf("%s\t%s\t%llu\n", results_names[c], r.columns[c].encoding == RESULTS_RAW ? "raw" : "delta",
+                   (unsigned long long)r.columns[c].bytes);
+        }
+        if (r.header.processes > 0) {
+            print_averages(stats);
+            print_percentiles(stats);
+        }
+    }
 
-typedef struct {
-    int algorithm;      // 1=FCFS, 2=SJF, 3=RR, 4=Priority
-    int quantum;        // For RR
-    int process_count;  // Number of processes in this queue
-    int process_indices[MAX_PROCESSES]; // Indices of processes in this queue
-} Queue;
+    free(stats);
+    results_close(&r);
+    return corrupt;
+}
 
+// Compare two results files of the same workload process by process and
+// segment by segment, then side by side. Returns 0 if they are the same,
+// 1 if they differ and 2 on error.
+int results_diff(const char *path_a, const char *path_b) {
+    enum { SHOWN = 10 };
+    Results a, b;
 
+    if (results_open(path_a, &a) != 0)
+        return 2;
+    if (results_open(path_b, &b) != 0) {
+        results_close(&a);
+        return 2;
+    }
+    if (a.header.processes != b.header.processes) {
+        fprintf(stderr, "%s has %llu processes and %s has %llu\n", path_a,
+                (unsigned long long)a.header.processes, path_b, (unsigned long long)b.header.processes);
+        results_close(&a);
+        results_close(&b);
+        return 2;
+    }
 
-void print_averages(Process processes[], int n) {
-    double total_waiting_time = 0, total_turnaround_time = 0;
+    static const int compared[] = { RESULTS_PID, RESULTS_ARRIVAL, RESULTS_BURST, RESULTS_COMPLETION,
+                                    RESULTS_WAITING, RESULTS_TURNAROUND };
+    enum { COMPARED = sizeof(compared) / sizeof(compared[0]) };
+    ColumnCursor ca[COMPARED], cb[COMPARED];
+    for (int c = 0; c < COMPARED; c++) {
+        cursor_init(&ca[c], &a, compared[c]);
+        cursor_init(&cb[c], &b, compared[c]);
+    }
 
-    for (int i = 0; i < n; i++) {
-        total_waiting_time += processes[i].waiting_time;
-        total_turnaround_time += processes[i].turnaround_time;
+    long long changed = 0, workload = 0, corrupt = 0;
+    for (uint64_t i = 0; i < a.header.processes; i++) {
+        int64_t va[COMPARED], vb[COMPARED];
+        for (int c = 0; c < COMPARED; c++) {
+            va[c] = cursor_next(&ca[c]);
+            vb[c] = cursor_next(&cb[c]);
+        }
+        if (va[1] != vb[1] || va[2] != vb[2]) {
+            workload++;
+            break;
+        }
+        if (va[3] == vb[3] && va[4] == vb[4])
+            continue;
+        if (changed++ == 0)
+            printf("PID\tWaiting A\tWaiting B\tTurnaround A\tTurnaround B\n");
+        if (changed <= SHOWN)
+            printf("%lld\t%lld\t%lld\t%lld\t%lld\n", (long long)va[0], (long long)va[4], (long long)vb[4],
+                   (long long)va[5], (long long)vb[5]);
     }
+    for (int c = 0; c < COMPARED; c++)
+        corrupt |= ca[c].corrupt | cb[c].corrupt;
 
-    printf("\nAverage Waiting Time: %.2f\n", total_waiting_time / n);
-    printf("Average Turnaround Time: %.2f\n", total_turnaround_time / n);
-}
+    // First place the charts part ways
+    ColumnCursor sa[3], sb[3];
+    uint64_t segments = a.header.segments < b.header.segments ? a.header.segments : b.header.segments;
+    uint64_t diverge = segments;
+    SimTime diverge_time = 0;
+    for (int c = 0; c < 3; c++) {
+        cursor_init(&sa[c], &a, RESULTS_SEGMENT_PID + c);
+        cursor_init(&sb[c], &b, RESULTS_SEGMENT_PID + c);
+    }
+    for (uint64_t s = 0; s < segments && diverge == segments; s++) {
+        int64_t pid_a = cursor_next(&sa[0]), pid_b = cursor_next(&sb[0]);
+        int64_t start_a = cursor_next(&sa[1]), start_b = cursor_next(&sb[1]);
+        int64_t end_a = cursor_next(&sa[2]), end_b = cursor_next(&sb[2]);
+        if (pid_a != pid_b || start_a != start_b || end_a != end_b) {
+            diverge = s;
+            diverge_time = start_a < start_b ? start_a : start_b;
+        }
+    }
+    for (int c = 0; c < 3; c++)
+        corrupt |= sa[c].corrupt | sb[c].corrupt;
 
-void fcfs(Process processes[], int n) {
-    int current_time = 0;
+    Stats *stats = malloc(sizeof(Stats) * 2);
+    SimTime makespan[2];
+    if (!corrupt && !workload) {
+        corrupt |= results_aggregate(&a, &stats[0], &makespan[0]);
+        corrupt |= results_aggregate(&b, &stats[1], &makespan[1]);
+    }
 
-    for (int i = 0; i < n; i++) {
-        if (current_time < processes[i].arrival_time)
-            current_time = processes[i].arrival_time;
-        processes[i].waiting_time = current_time - processes[i].arrival_time;
-        processes[i].turnaround_time = processes[i].waiting_time + processes[i].burst_time;
-        current_time += processes[i].burst_time;
+    int status;
+    if (corrupt) {
+        fprintf(stderr, "%s or %s is corrupt\n", path_a, path_b);
+        status = 2;
+    } else if (workload) {
+        fprintf(stderr, "%s and %s are not from the same workload\n", path_a, path_b);
+        status = 2;
+    } else {
+        if (changed > SHOWN)
+            printf("... and %lld more\n", changed - SHOWN);
+        printf("%s%lld of %llu processes finished differently\n", changed > 0 ? "\n" : "", changed,
+               (unsigned long long)a.header.processes);
+        if (diverge < segments)
+            printf("Charts diverge at segment %llu, time %lld\n", (unsigned long long)diverge, diverge_time);
+        else if (a.header.segments != b.header.segments)
+            printf("Charts agree for %llu segments, then one ends\n", (unsigned long long)segments);
+        else
+            printf("Charts are identical\n");
+
+        printf("\n%-20s%-16s%-16s%s\n", "", algorithm_name(a.header.algorithm),
+               algorithm_name(b.header.algorithm), "Change");
+        const Histogram *rows[2][3] = {
+            { &stats[0].waiting, &stats[0].turnaround, &stats[0].response },
+            { &stats[1].waiting, &stats[1].turnaround, &stats[1].response },
+        };
+        const char *names[3] = { "Waiting", "Turnaround", "Response" };
+        for (int m = 0; m < 3 && a.header.processes > 0; m++) {
+            double mean_a = histogram_mean(rows[0][m]), mean_b = histogram_mean(rows[1][m]);
+            SimTime p99_a = histogram_percentile(rows[0][m], 99), p99_b = histogram_percentile(rows[1][m], 99);
+            char label[32];
+            snprintf(label, sizeof(label), "Avg %s", names[m]);
+            printf("%-20s%-16.2f%-16.2f%+.2f\n", label, mean_a, mean_b, mean_b - mean_a);
+            snprintf(label, sizeof(label), "p99 %s", names[m]);
+            printf("%-20s%-16lld%-16lld%+lld\n", label, p99_a, p99_b, p99_b - p99_a);
+        }
+        printf("%-20s%-16lld%-16lld%+lld\n", "Makespan", makespan[0], makespan[1], makespan[1] - makespan[0]);
+        printf("%-20s%-16llu%-16llu%+lld\n", "Segments", (unsigned long long)a.header.segments,
+               (unsigned long long)b.header.segments, (long long)(b.header.segments - a.header.segments));
+        status = changed > 0 || diverge < segments || a.header.segments != b.header.segments;
     }
 
-    printf("\nFCFS Results:\n");
-    printf("PID\tArrival\tBurst\tWaiting\tTurnaround\n");
-    for (int i = 0; i < n; i++) {
-        printf("%d\t%d\t%d\t%d\t%d\n", processes[i].pid, processes[i].arrival_time,
-               processes[i].burst_time, processes[i].waiting_time, processes[i].turnaround_time);
+    free(stats);
+    results_close(&a);
+    results_close(&b);
+    return status;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming
+// ---------------------------------------------------------------------------
+
+// Statistics of the processes that finished in one window of simulated time
+typedef struct {
+    SimTime width;
+    SimTime start;          // Of the window being filled
+    Stats stats;
+} StreamWindow;
+
+// Stream source reading a trace
+static int trace_read(void *source, ProcessTable *t, int i) {
+    TraceRecord record;
+    int status = trace_next(source, &record);
+
+    if (status > 0 && record.period > 0) {
+        fprintf(stderr, "Periodic tasks can't be streamed\n");
+        return -1;
     }
+    if (status > 0 && ((TraceReader *)source)->step_count > 0) {
+        fprintf(stderr, "Processes with I/O bursts can't be streamed\n");
+        return -1;
+    }
+    if (status > 0 && ((TraceReader *)source)->kernel != NULL) {
+        // Its bursts come out as they end, not in arrival order
+        fprintf(stderr, "Kernel traces can't be streamed; load them without --stream\n");
+        return -1;
+    }
+    if (status > 0) {
+        t->arrival_time[i] = record.arrival_time;
+        t->burst_time[i] = record.burst_time;
+        t->priority[i] = record.priority;
+        t->queue[i] = record.queue;
+        t->deadline[i] = record.deadline;
+    }
+    return status;
+}
 
-    print_averages(processes, n);
+static void window_flush(StreamWindow *w, int active) {
+    const Stats *st = &w->stats;
+    if (st->waiting.count == 0)
+        return;
+
+    printf("%lld\t%lld\t%d\t%.2f\t%lld\t%.2f\t%lld\n", w->start, st->waiting.count, active,
+           histogram_mean(&st->waiting), histogram_percentile(&st->waiting, 99),
+           histogram_mean(&st->turnaround), histogram_percentile(&st->turnaround, 99));
+    fflush(stdout);
+    stats_init(&w->stats);
 }
 
-void sjf(Process processes[], int n) {
-    int completed = 0, current_time = 0;
-    int min_index;
+// Record a completion, first printing the window before it if it finished
+// past that window's end. Windows nothing finished in are left out.
+static void window_record(void *ctx, const ProcessTable *t, int idx, int active) {
+    StreamWindow *w = ctx;
+    SimTime now = t->completion_time[idx];
 
-    while (completed < n) {
-        min_index = -1;
+    if (now - w->start >= w->width) {
+        window_flush(w, active);
+        w->start = now - now % w->width;
+    }
+    stats_record(&w->stats, t, idx);
+}
 
-        for (int i = 0; i < n; i++) {
-            if (processes[i].remaining_time > 0 && processes[i].arrival_time <= current_time) {
-                if (min_index == -1 || processes[i].remaining_time < processes[min_index].remaining_time) {
-                    min_index = i;
-                }
-            }
-        }
+// Stream algorithm 1-5 over a trace, or the generator if trace is NULL,
+// printing statistics for every window of simulated time (none if window is
+// 0) and then for the whole run. Returns nonzero on bad input.
+int stream_algorithm(TraceReader *trace, const GeneratorConfig *g, int algorithm, int quantum, SimTime window,
+                     Gantt *gantt, Metrics *metrics) {
+    Stream s;
+    Generator generator;
+    ReadyQueue rq;
+    Policy policy;
+    Stats *stats = malloc(sizeof(Stats));
+    StreamWindow *w = window > 0 ? malloc(sizeof(StreamWindow)) : NULL;
+    double start = 0;
 
-        if (min_index == -1) {
-            current_time++;
-            continue;
-        }
+    if (trace != NULL) {
+        stream_init(&s, trace_read, trace);
+    } else {
+        generator_init(&generator, g, 0);
+        stream_init(&s, generator_read, &generator);
+    }
+    policy_init(&policy, &rq, &s.table, 64, algorithm, quantum, gantt);
+    stats_init(stats);
+    policy.stats = stats;
+    policy.metrics = metrics;
+    if (metrics != NULL)
+        metrics_init(metrics, algorithm_names[algorithm - 1]);
 
-        current_time += processes[min_index].burst_time;
-        processes[min_index].completion_time = current_time;
-        processes[min_index].turnaround_time = processes[min_index].completion_time - processes[min_index].arrival_time;
-        processes[min_index].waiting_time = processes[min_index].turnaround_time - processes[min_index].burst_time;
-        processes[min_index].remaining_time = 0;
-        completed++;
+    printf("\n%s Stream Results:\n", algorithm_names[algorithm - 1]);
+    if (w != NULL) {
+        w->width = window;
+        w->start = 0;
+        stats_init(&w->stats);
+        s.finished = window_record;
+        s.ctx = w;
+        printf("\nWindow\tCompleted\tActive\tAvg Waiting\tp99 Waiting\tAvg Turnaround\tp99 Turnaround\n");
     }
 
-    printf("\nSJF Results:\n");
-    printf("PID\tArrival\tBurst\tWaiting\tTurnaround\n");
-    for (int i = 0; i < n; i++) {
-        printf("%d\t%d\t%d\t%d\t%d\n", processes[i].pid, processes[i].arrival_time,
-               processes[i].burst_time, processes[i].waiting_time, processes[i].turnaround_time);
+    gantt_begin(gantt, algorithm, 0);
+    METRIC(if (metrics != NULL) start = wall_clock());
+    SimTime makespan = simulate_stream(&s, &policy);
+    METRIC(if (metrics != NULL) metrics->simulate_seconds = wall_clock() - start);
+    gantt_end(gantt);
+
+    int status = makespan < 0;
+    if (s.out_of_order >= 0)
+        fprintf(stderr, "Stream is out of order: process %lld arrives at %lld, after one at %lld\n",
+                s.admitted + 1, s.out_of_order, s.last_arrival);
+    if (status == 0 && s.admitted == 0) {
+        fprintf(stderr, "Stream has no processes\n");
+        status = 1;
+    }
+    if (status == 0) {
+        METRIC(if (metrics != NULL) start = wall_clock());
+        if (w != NULL)
+            window_flush(w, 0);
+        printf("\nProcesses: %lld\n", s.admitted);
+        printf("Peak active: %d\n", s.peak);
+        printf("Makespan: %lld\n", makespan);
+        print_averages(stats);
+        print_percentiles(stats);
+        METRIC(if (metrics != NULL) metrics->report_seconds = wall_clock() - start);
     }
 
-    print_averages(processes, n);
+    ready_free(&rq);
+    stream_free(&s);
+    free(w);
+    free(stats);
+    return status;
 }
 
-void rr(Process processes[], int n, int quantum) {
-    int current_time = 0, completed = 0;
-    int remaining_bt[n];
-    for (int i = 0; i < n; i++) {
-        remaining_bt[i] = processes[i].burst_time;
-    }
+// ---------------------------------------------------------------------------
+// Batch mode
+// ---------------------------------------------------------------------------
 
-    printf("\nRR Results:\n");
-    printf("PID\tArrival\tBurst\tWaiting\tTurnaround\n");
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s -i TRACE -a ALGORITHM [options]\n"
+            "       %s -n COUNT -a ALGORITHM [generator options]\n"
+            "       %s            (interactive mode)\n"
+            "\n"
+            "  -i, --input FILE        Trace file, binary or CSV with lines\n"
+            "                          arrival,burst[,priority[,queue[,deadline[,period]]]]\n"
+            "                          (a burst CPU/DEVICE:SERVICE/CPU/... also blocks on\n"
+            "                          I/O devices 0-15, each serving one request at a time),\n"
+            "                          or ftrace / perf script text with sched_switch and\n"
+            "                          sched_wakeup events (one process per CPU burst, in us)\n"
+            "  -n, --generate N        Generate a synthetic workload of N processes instead\n"
+            "  -a, --algorithm NAME    fcfs, sjf, rr, priority, srt, all, mlq, mlfq, cfs,\n"
+            "                          edf, rm, sweep or bench\n"
+            "  -q, --quantum N         Time quantum for rr and all\n"
+            "  -Q, --queues LIST       Multilevel queues, highest first, e.g. rr:4,sjf,fcfs\n"
+            "  -L, --levels LIST       MLFQ quanta, highest level first (default 4,8,16);\n"
+            "                          the last may be 0 to run to completion\n"
+            "  -B, --boost N           Move every MLFQ process back to the top level every\n"
+            "                          N time units (default 100, 0 = never)\n"
+            "  --latency N             CFS target latency (default 24)\n"
+            "  --min-granularity N     Shortest CFS slice (default 3); priorities are nice values\n"
+            "  --horizon N             Release periodic tasks up to time N (default one\n"
+            "                          hyperperiod after the last one starts). A process with\n"
+            "                          a period releases a job every period; deadlines are\n"
+            "                          relative, 0 = none (the period for a periodic task)\n"
+            "  -c, --cpus N            Simulate fcfs..srt, edf or rm on N cores with per-core\n"
+            "                          queues\n"
+            "  --placement POLICY      Core for each arrival: rr (default), least or random\n"
+            "  --balance MODE          steal (idle cores take queued work, default),\n"
+            "                          periodic:N (even out queues every N) or none\n"
+            "  -w, --write-trace FILE  Save the loaded workload as a binary trace\n"
+            "  -g, --gantt MODE        Gantt chart on stdout: text (default) or none\n"
+            "  -G, --gantt-file FILE   Write Gantt segments to a binary file\n"
+            "  --checkpoint FILE       Save the run's state just before the last arrivals,\n"
+            "                          which a longer trace can resume from (fcfs..srt,\n"
+            "                          mlfq and cfs on one CPU)\n"
+            "  --checkpoint-every N    Also save it after every N slices\n"
+            "  --resume FILE           Start from a checkpoint instead of time 0; extra\n"
+            "                          processes must arrive no earlier than its time\n"
+            "  -m, --metrics FILE      Save scheduling counters and load, simulate and report\n"
+            "                          times, as JSON if FILE ends in .json, CSV otherwise\n"
+            "  -o, --results FILE      Save per-process results and the Gantt segments as a\n"
+            "                          columnar binary file (not with all)\n"
+            "  --compress MODE         Results file columns: none (default) or delta\n"
+            "  --stream WINDOW         Read the input as the clock reaches each arrival and drop\n"
+            "                          finished processes, so memory follows the active ones;\n"
+            "                          prints statistics every WINDOW time units (0 = totals\n"
+            "                          only). Needs an arrival-sorted trace (- for stdin) or\n"
+            "                          --generate, fcfs..srt on one CPU; charts only go to -G\n"
+            "  --summarize FILE        Print the totals and percentiles of a results file\n"
+            "  --diff FILE             With --summarize, compare FILE against it process by\n"
+            "                          process; exits 1 if they differ\n"
+            "\n"
+            "Sweep mode (-a sweep) ranks configurations by average waiting time:\n"
+            "  -R, --quantum-range MIN:MAX[:STEP]  RR quanta to try\n"
+            "  -S, --queue-sets LIST   Multilevel queue sets separated by ';', e.g.\n"
+            "                          'rr:4,sjf;rr,fcfs' (an rr without a quantum\n"
+            "                          takes every quantum from --quantum-range)\n"
+            "\n"
+            "Generator options:\n"
+            "  --arrivals SPEC         poisson:MEAN_GAP (default poisson:10) or\n"
+            "                          bursty:MEAN_GAP:MEAN_BATCH\n"
+            "  --bursts SPEC           exp:MEAN (default exp:8), pareto:ALPHA:MIN or\n"
+            "                          bimodal:SHORT_MEAN:LONG_MEAN:P_LONG\n"
+            "  --periodic U:MIN:MAX    Draw periodic tasks instead, released at 0 with total\n"
+            "                          utilization U and log-uniform periods in MIN..MAX,\n"
+            "                          longer where a task's share won't fill one time unit\n"
+            "  --io D:R:MEAN           Split each process's CPU demand around R requests to\n"
+            "                          random ones of D devices, with exponential service\n"
+            "                          times of mean MEAN (fcfs..srt, all and rr sweeps)\n"
+            "  --priorities N          Draw priorities uniformly from 0..N-1\n"
+            "  --seed S                Random seed (default 1)\n"
+            "  -r, --replications R    Simulate R independent workloads in parallel and\n"
+            "                          report means with 95%% confidence intervals\n"
+            "\n"
+            "Benchmark mode (-a bench) times fcfs..srt, mlfq and cfs on generated workloads of\n"
+            "1000, 10000, ... processes (generator options apply, rr uses -q, default 4):\n"
+            "  --bench-max N           Largest workload (default 10000000)\n"
+            "  --baseline FILE         Compare against a saved baseline, exit 1 on regressions\n"
+            "  --save-baseline FILE    Save the results as the new baseline\n"
+            "  --threshold PCT         Allowed slowdown or memory growth (default 10)\n",
+            prog, prog, prog);
+}
+
+// Parse "poisson:MEAN" or "bursty:MEAN:BATCH"
+static int parse_arrivals(const char *spec, GeneratorConfig *g) {
+    if (sscanf(spec, "poisson:%lf", &g->arrival_mean) == 1 && g->arrival_mean > 0) {
+        g->arrival_kind = ARRIVAL_POISSON;
+        return 0;
+    }
+    if (sscanf(spec, "bursty:%lf:%lf", &g->arrival_mean, &g->batch_mean) == 2 &&
+        g->arrival_mean > 0 && g->batch_mean >= 1) {
+        g->arrival_kind = ARRIVAL_BURSTY;
+        return 0;
+    }
+    fprintf(stderr, "Arrivals must be poisson:MEAN or bursty:MEAN:BATCH\n");
+    return -1;
+}
 
+// Parse "exp:MEAN", "pareto:ALPHA:MIN" or "bimodal:SHORT:LONG:P"
+static int parse_bursts(const char *spec, GeneratorConfig *g) {
+    if (sscanf(spec, "exp:%lf", &g->burst_a) == 1 && g->burst_a > 0) {
+        g->burst_kind = BURST_EXPONENTIAL;
+        return 0;
+    }
+    if (sscanf(spec, "pareto:%lf:%lf", &g->burst_a, &g->burst_b) == 2 && g->burst_a > 0 && g->burst_b > 0) {
+        g->burst_kind = BURST_PARETO;
+        return 0;
+    }
+    if (sscanf(spec, "bimodal:%lf:%lf:%lf", &g->burst_a, &g->burst_b, &g->burst_p) == 3 &&
+        g->burst_a > 0 && g->burst_b > 0 && g->burst_p >= 0 && g->burst_p <= 1) {
+        g->burst_kind = BURST_BIMODAL;
+        return 0;
+    }
+    fprintf(stderr, "Bursts must be exp:MEAN, pareto:ALPHA:MIN or bimodal:SHORT:LONG:P\n");
+    return -1;
+}
 
-    while (completed < n) {
-        int executed = 0;
+// Parse "UTILIZATION:MIN_PERIOD:MAX_PERIOD"
+static int parse_periodic(const char *spec, GeneratorConfig *g) {
+    if (sscanf(spec, "%lf:%lld:%lld", &g->utilization, &g->period_min, &g->period_max) == 3 &&
+        g->utilization > 0 && g->period_min >= 1 && g->period_max >= g->period_min)
+        return 0;
+    fprintf(stderr, "Periodic tasks must be UTILIZATION:MIN_PERIOD:MAX_PERIOD\n");
+    return -1;
+}
+// Parse "DEVICES:REQUESTS:MEAN_SERVICE"
+static int parse_io(const char *spec, GeneratorConfig *g) {
+    if (sscanf(spec, "%d:%d:%lf", &g->devices, &g->io_requests, &g->io_service) == 3 &&
+        g->devices >= 1 && g->devices <= IO_MAX_DEVICES && g->io_requests >= 1 && g->io_service > 0)
+        return 0;
+    fprintf(stderr, "I/O must be DEVICES:REQUESTS:MEAN_SERVICE with 1-%d devices and at least one request\n",
+            IO_MAX_DEVICES);
+    return -1;
+}
 
-        for (int i = 0; i < n; i++) {
-            if (processes[i].arrival_time <= current_time && remaining_bt[i] > 0) {
-                executed = 1;
-                if (remaining_bt[i] > quantum) {
-                    for (int j = 0; j < quantum; j++) printf("P%d ", processes[i].pid);
-                    current_time += quantum;
-                    remaining_bt[i] -= quantum;
-                    printf("|");
-                } else {
-                    for (int j = 0; j < remaining_bt[i]; j++) printf("P%d ", processes[i].pid);
-                    current_time += remaining_bt[i];
-                    processes[i].waiting_time = current_time - processes[i].arrival_time - processes[i].burst_time;
-                    processes[i].turnaround_time = current_time - processes[i].arrival_time;
-                    remaining_bt[i] = 0;
-                    completed++;
-                    printf("|");
-                }
-            }
-        }
+// Algorithm names map onto the interactive menu numbers
+static int parse_algorithm(const char *name) {
+    static const char *names[] = {
+        "fcfs", "sjf", "rr", "priority", "srt", "all", "mlq", "mlfq", "cfs", "sweep", "bench", "edf", "rm"
+    };
 
-        if (!executed)
-            current_time++;
+    for (int i = 0; i < 13; i++) {
+        if (strcmp(name, names[i]) == 0)
+            return i + 1;
     }
-    printf("\n");
-    print_averages(processes, n);
+    return atoi(name);
 }
 
-void priority(Process processes[], int n) {
-    int completed = 0, current_time = 0;
-    int visited[n];
-    for (int i = 0; i < n; i++) {
-        visited[i] = 0;
+// Parse "name[:quantum],..." into a freshly allocated queue array. Returns the
+// number of queues, or -1 on a malformed list. With swept set, rr may leave
+// its quantum out (0) to have it filled in by a sweep.
+static int parse_queues(const char *spec, Queue **queues, int swept) {
+    int num_queues = 1;
+    for (const char *c = spec; *c; c++) {
+        if (*c == ',')
+            num_queues++;
     }
+    *queues = malloc(sizeof(Queue) * num_queues);
 
-    while (completed < n) {
-        int idx = -1, min_priority = INT_MAX;
+    const char *p = spec;
+    for (int q = 0; q < num_queues; q++) {
+        char name[16];
+        size_t len = strcspn(p, ":,");
+        if (len == 0 || len >= sizeof(name)) {
+            fprintf(stderr, "Bad queue %d in '%s'\n", q, spec);
+            return -1;
+        }
+        memcpy(name, p, len);
+        name[len] = '\0';
+        p += len;
 
-        for (int i = 0; i < n; i++) {
-            if (!visited[i] && processes[i].arrival_time <= current_time) {
-                if (processes[i].priority < min_priority ||
-                    (processes[i].priority == min_priority && processes[i].arrival_time < processes[idx].arrival_time)) {
-                    min_priority = processes[i].priority;
-                    idx = i;
-                }
-            }
+        Queue *queue = &(*queues)[q];
+        queue->algorithm = parse_algorithm(name);
+        queue->quantum = 0;
+        if (*p == ':') {
+            queue->quantum = atoi(++p);
+            p += strcspn(p, ",");
         }
+        if (queue->algorithm < 1 || queue->algorithm > 4) {
+            fprintf(stderr, "Queue %d: algorithm must be fcfs, sjf, rr or priority\n", q);
+            return -1;
+        }
+        if (queue->algorithm == 3 && queue->quantum <= 0 && !(swept && queue->quantum == 0)) {
+            fprintf(stderr, "Queue %d: rr needs a positive quantum, e.g. rr:4\n", q);
+            return -1;
+        }
+        if (*p == ',')
+            p++;
+    }
 
-        if (idx != -1) {
-            visited[idx] = 1;
-            current_time += processes[idx].burst_time;
-            processes[idx].completion_time = current_time;
-            processes[idx].turnaround_time = processes[idx].completion_time - processes[idx].arrival_time;
-            processes[idx].waiting_time = processes[idx].turnaround_time - processes[idx].burst_time;
-            completed++;
-        } else {
-            current_time++;
+    return num_queues;
+}
+
+// Parse "quantum,quantum,..." into the MLFQ levels, highest first
+static int parse_levels(const char *spec, FeedbackConfig *feedback) {
+    const char *p = spec;
+
+    feedback->num_levels = 0;
+    while (*p) {
+        char *end;
+        long long quantum = strtoll(p, &end, 10);
+        if (end == p || quantum < 0 || feedback->num_levels == MLFQ_MAX_LEVELS) {
+            fprintf(stderr, "Levels must be up to %d non-negative quanta, e.g. 4,8,16\n", MLFQ_MAX_LEVELS);
+            return -1;
+        }
+        feedback->quantum[feedback->num_levels++] = quantum;
+        p = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            fprintf(stderr, "Bad level list '%s'\n", spec);
+            return -1;
         }
     }
 
-    printf("\nPriority Results:\n");
-    printf("PID\tArrival\tBurst\tPriority\tWaiting\tTurnaround\n");
-    for (int i = 0; i < n; i++) {
-        printf("%d\t%d\t%d\t%d\t%d\t%d\n", processes[i].pid, processes[i].arrival_time,
-               processes[i].burst_time, processes[i].priority, processes[i].waiting_time, processes[i].turnaround_time);
+    for (int l = 0; l + 1 < feedback->num_levels; l++) {
+        if (feedback->quantum[l] == 0) {
+            fprintf(stderr, "Only the last MLFQ level can run to completion (quantum 0)\n");
+            return -1;
+        }
     }
+    if (feedback->num_levels == 0) {
+        fprintf(stderr, "MLFQ needs at least one level\n");
+        return -1;
+    }
+    return 0;
+}
 
-    print_averages(processes, n);
+static int parse_placement(const char *name, SmpConfig *smp) {
+    if (strcmp(name, "rr") == 0)
+        smp->placement = PLACE_ROUND_ROBIN;
+    else if (strcmp(name, "least") == 0)
+        smp->placement = PLACE_LEAST_LOADED;
+    else if (strcmp(name, "random") == 0)
+        smp->placement = PLACE_RANDOM;
+    else {
+        fprintf(stderr, "Placement must be rr, least or random\n");
+        return -1;
+    }
+    return 0;
 }
 
-void srt(Process processes[], int n) {
-    int completed = 0, current_time = 0, shortest = -1, min_remaining;
+// Parse "steal", "none" or "periodic:PERIOD"
+static int parse_balance(const char *spec, SmpConfig *smp) {
+    long long period;
 
-    for (int i = 0; i < n; i++) {
-        processes[i].remaining_time = processes[i].burst_time;
+    if (strcmp(spec, "steal") == 0) {
+        smp->balance = BALANCE_STEAL;
+    } else if (strcmp(spec, "none") == 0) {
+        smp->balance = BALANCE_NONE;
+    } else if (sscanf(spec, "periodic:%lld", &period) == 1 && period > 0) {
+        smp->balance = BALANCE_PERIODIC;
+        smp->balance_period = period;
+    } else {
+        fprintf(stderr, "Balance must be steal, none or periodic:PERIOD\n");
+        return -1;
     }
+    return 0;
+}
 
-    printf("\nSRT Results:\n");
-    printf("PID\tArrival\tBurst\tWaiting\tTurnaround\n");
+static int add_sweep_config(SweepConfig **configs, int *count, int algorithm, int quantum,
+                            const Queue queues[], int num_queues) {
+    *configs = realloc(*configs, sizeof(SweepConfig) * (*count + 1));
+    SweepConfig *c = &(*configs)[(*count)++];
+
+    c->algorithm = algorithm;
+    c->quantum = quantum;
+    c->queues = NULL;
+    c->num_queues = num_queues;
+    c->cpu_utilization = 0;
+    if (algorithm == 3) {
+        snprintf(c->label, sizeof(c->label), "rr q=%d", quantum);
+    } else {
+        // Each configuration gets its own queues; workers write their ranges
+        c->queues = malloc(sizeof(Queue) * num_queues);
+        for (int q = 0; q < num_queues; q++) {
+            c->queues[q] = queues[q];
+            if (c->queues[q].algorithm == 3 && c->queues[q].quantum == 0)
+                c->queues[q].quantum = quantum;
+        }
+        queue_label(c);
+    }
+    return 0;
+}
 
-   
-    while (completed < n) {
-        shortest = -1;
-        min_remaining = INT_MAX;
+// Expand --quantum-range and --queue-sets into the list of configurations.
+// Returns the number of configurations, or -1 on bad arguments.
+static int build_sweep(const char *quantum_range, const char *queue_sets, SweepConfig **configs) {
+    int min = 0, max = -1, step = 1, count = 0;
+    *configs = NULL;
 
-        for (int i = 0; i < n; i++) {
-            if (processes[i].remaining_time > 0 && processes[i].arrival_time <= current_time &&
-                processes[i].remaining_time < min_remaining) {
-                min_remaining = processes[i].remaining_time;
-                shortest = i;
-            }
+    if (quantum_range != NULL) {
+        int fields = sscanf(quantum_range, "%d:%d:%d", &min, &max, &step);
+        if (fields < 2 || min <= 0 || max < min || step <= 0) {
+            fprintf(stderr, "Quantum range must be MIN:MAX[:STEP] with 0 < MIN <= MAX\n");
+            return -1;
         }
+        for (int quantum = min; quantum <= max; quantum += step)
+            add_sweep_config(configs, &count, 3, quantum, NULL, 0);
+    }
 
-        if (shortest == -1) {
-            current_time++;
-            continue;
+    for (const char *set = queue_sets; set != NULL && *set; ) {
+        size_t len = strcspn(set, ";");
+        char *spec = malloc(len + 1);
+        memcpy(spec, set, len);
+        spec[len] = '\0';
+        set += len + (set[len] == ';');
+
+        Queue *queues = NULL;
+        int num_queues = parse_queues(spec, &queues, 1);
+        int swept = 0;
+        for (int q = 0; q < num_queues; q++)
+            swept |= queues[q].algorithm == 3 && queues[q].quantum == 0;
+
+        if (num_queues > 0 && swept && quantum_range == NULL) {
+            fprintf(stderr, "Queue set '%s' has rr without a quantum but no --quantum-range\n", spec);
+            num_queues = -1;
+        }
+        if (num_queues > 0 && swept) {
+            for (int quantum = min; quantum <= max; quantum += step)
+                add_sweep_config(configs, &count, 7, quantum, queues, num_queues);
+        } else if (num_queues > 0) {
+            add_sweep_config(configs, &count, 7, 0, queues, num_queues);
         }
 
-        printf("P%d ", processes[shortest].pid);
-        current_time++;
-        processes[shortest].remaining_time--;
+        free(queues);
+        free(spec);
+        if (num_queues < 0)
+            return -1;
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "Sweep needs --quantum-range and/or --queue-sets\n");
+        return -1;
+    }
+    return count;
+}
+
+// Batch run in streaming mode: the input is never loaded as a whole
+static int batch_stream(const char *input, const GeneratorConfig *gen, int choice, int quantum, SimTime window,
+                        const char *gantt_file, const char *metrics_file) {
+    TraceReader trace;
+    FILE *segments = NULL;
+    Metrics metrics[1];
+    Chart chart;
 
-        if (processes[shortest].remaining_time == 0) {
-            completed++;
-            processes[shortest].completion_time = current_time;
-            processes[shortest].turnaround_time = current_time - processes[shortest].arrival_time;
-            processes[shortest].waiting_time = processes[shortest].turnaround_time - processes[shortest].burst_time;
-            printf("|");
+    if (input != NULL && trace_open(&trace, input) != 0)
+        return 1;
+    if (gantt_file != NULL) {
+        segments = fopen(gantt_file, "wb");
+        if (segments == NULL) {
+            fprintf(stderr, "Cannot create Gantt file %s\n", gantt_file);
+            if (input != NULL)
+                trace_close(&trace);
+            return 1;
         }
+        fwrite(GANTT_MAGIC, 1, sizeof(GANTT_MAGIC) - 1, segments);
     }
-    printf("\n");
-    print_averages(processes, n);
+
+    Gantt *gantt = chart_open(&chart, NULL, segments);
+    int status = stream_algorithm(input != NULL ? &trace : NULL, gen, choice, quantum, window, gantt,
+                                  metrics_file != NULL ? metrics : NULL);
+    chart_close(&chart);
+    if (status == 0 && metrics_file != NULL && metrics_save(metrics_file, metrics, 1, 0) != 0)
+        status = 1;
+
+    if (segments != NULL && fclose(segments) != 0) {
+        fprintf(stderr, "Error writing Gantt file %s\n", gantt_file);
+        status = 1;
+    }
+    if (input != NULL)
+        trace_close(&trace);
+    return status;
 }
 
-void multilevel_queue(Process processes[], int n, Queue queues[], int num_queues) {
-    int current_time = 0;
-    
-    printf("\n=== Multilevel Queue Scheduling ===\n");
-    
-    // Process each queue in priority order (each queue completes before next one starts)
-    for (int q = 0; q < num_queues; q++) {
-        if (queues[q].process_count == 0) {
-            printf("\n--- Queue %d: Empty ---\n", q);
-            continue;
+int batch_main(int argc, char *argv[]) {
+    const char *input = NULL, *queue_spec = NULL, *write_trace = NULL, *gantt_file = NULL;
+    const char *quantum_range = NULL, *queue_sets = NULL;
+    const char *baseline = NULL, *save_baseline = NULL, *resume = NULL, *metrics_file = NULL;
+    const char *results_file = NULL, *summarize = NULL, *diff = NULL;
+    int choice = 0, quantum = 0, gantt_text = 1, replications = 1, bench_max = 10000000;
+    int encoding = RESULTS_RAW;
+    SimTime stream_window = -1, horizon = 0;
+    double threshold = 10;
+    FeedbackConfig feedback = { 3, { 4, 8, 16 }, 100 };
+    FairConfig fair = { 24, 3 };
+    SmpConfig smp = { 1, PLACE_ROUND_ROBIN, BALANCE_STEAL, 0, 1 };
+    GeneratorConfig gen = { 0, ARRIVAL_POISSON, 10, 1, BURST_EXPONENTIAL, 8, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 1 };
+    Checkpointer checkpoint = { NULL, NULL, 0, NULL, 0, 0, 0, 0, 0, 0 };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
         }
-        
-        // Create a temporary array with only processes from this queue
-        Process queue_processes[MAX_PROCESSES];
-        int queue_size = queues[q].process_count;
-        
-        // Copy processes for this queue
-        for (int i = 0; i < queue_size; i++) {
-            int idx = queues[q].process_indices[i];
-            queue_processes[i] = processes[idx];
-            // Processes in this queue can't start before the queue becomes active
-            if (queue_processes[i].arrival_time < current_time) {
-                queue_processes[i].arrival_time = current_time;
+        if (value == NULL) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "-i") == 0 || strcmp(arg, "--input") == 0) {
+            input = value;
+        } else if (strcmp(arg, "-a") == 0 || strcmp(arg, "--algorithm") == 0) {
+            choice = parse_algorithm(value);
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quantum") == 0) {
+            quantum = atoi(value);
+        } else if (strcmp(arg, "-Q") == 0 || strcmp(arg, "--queues") == 0) {
+            queue_spec = value;
+        } else if (strcmp(arg, "-L") == 0 || strcmp(arg, "--levels") == 0) {
+            if (parse_levels(value, &feedback) != 0)
+                return 1;
+        } else if (strcmp(arg, "-B") == 0 || strcmp(arg, "--boost") == 0) {
+            feedback.boost = atoll(value);
+        } else if (strcmp(arg, "--latency") == 0) {
+            fair.latency = atoll(value);
+        } else if (strcmp(arg, "--min-granularity") == 0) {
+            fair.min_granularity = atoll(value);
+        } else if (strcmp(arg, "-c") == 0 || strcmp(arg, "--cpus") == 0) {
+            smp.cpus = atoi(value);
+        } else if (strcmp(arg, "--placement") == 0) {
+            if (parse_placement(value, &smp) != 0)
+                return 1;
+        } else if (strcmp(arg, "--balance") == 0) {
+            if (parse_balance(value, &smp) != 0)
+                return 1;
+        } else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--write-trace") == 0) {
+            write_trace = value;
+        } else if (strcmp(arg, "-g") == 0 || strcmp(arg, "--gantt") == 0) {
+            if (strcmp(value, "text") != 0 && strcmp(value, "none") != 0) {
+                fprintf(stderr, "Gantt mode must be text or none\n");
+                return 1;
+            }
+            gantt_text = strcmp(value, "text") == 0;
+        } else if (strcmp(arg, "-G") == 0 || strcmp(arg, "--gantt-file") == 0) {
+            gantt_file = value;
+        } else if (strcmp(arg, "--checkpoint") == 0) {
+            checkpoint.save = checkpoint_save;
+            checkpoint.ctx = (void *)value;
+        } else if (strcmp(arg, "--checkpoint-every") == 0) {
+            checkpoint.every = atoll(value);
+        } else if (strcmp(arg, "--resume") == 0) {
+            resume = value;
+        } else if (strcmp(arg, "-m") == 0 || strcmp(arg, "--metrics") == 0) {
+            metrics_file = value;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--results") == 0) {
+            results_file = value;
+        } else if (strcmp(arg, "--compress") == 0) {
+            if (strcmp(value, "none") != 0 && strcmp(value, "delta") != 0) {
+                fprintf(stderr, "Compression must be none or delta\n");
+                return 1;
+            }
+            encoding = strcmp(value, "delta") == 0 ? RESULTS_DELTA : RESULTS_RAW;
+        } else if (strcmp(arg, "--stream") == 0) {
+            stream_window = atoll(value);
+            if (stream_window < 0) {
+                fprintf(stderr, "--stream needs a non-negative window\n");
+                return 1;
             }
+        } else if (strcmp(arg, "--summarize") == 0) {
+            summarize = value;
+        } else if (strcmp(arg, "--diff") == 0) {
+            diff = value;
+        } else if (strcmp(arg, "-R") == 0 || strcmp(arg, "--quantum-range") == 0) {
+            quantum_range = value;
+        } else if (strcmp(arg, "-S") == 0 || strcmp(arg, "--queue-sets") == 0) {
+            queue_sets = value;
+        } else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--generate") == 0) {
+            gen.count = atoi(value);
+        } else if (strcmp(arg, "--arrivals") == 0) {
+            if (parse_arrivals(value, &gen) != 0)
+                return 1;
+        } else if (strcmp(arg, "--bursts") == 0) {
+            if (parse_bursts(value, &gen) != 0)
+                return 1;
+        } else if (strcmp(arg, "--periodic") == 0) {
+            if (parse_periodic(value, &gen) != 0)
+                return 1;
+        } else if (strcmp(arg, "--io") == 0) {
+            if (parse_io(value, &gen) != 0)
+                return 1;
+        } else if (strcmp(arg, "--horizon") == 0) {
+            horizon = atoll(value);
+            if (horizon < 1) {
+                fprintf(stderr, "--horizon must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--priorities") == 0) {
+            gen.priorities = atoi(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            gen.seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--replications") == 0) {
+            replications = atoi(value);
+        } else if (strcmp(arg, "--bench-max") == 0) {
+            bench_max = atoi(value);
+        } else if (strcmp(arg, "--baseline") == 0) {
+            baseline = value;
+        } else if (strcmp(arg, "--save-baseline") == 0) {
+            save_baseline = value;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            threshold = atof(value);
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            usage(argv[0]);
+            return 1;
         }
-        
-        // Display queue header
-        printf("\n--- Queue %d ", q);
-        switch (queues[q].algorithm) {
-            case 1: printf("(FCFS)"); break;
-            case 2: printf("(SJF)"); break;
-            case 3: printf("(RR, q=%d)", queues[q].quantum); break;
-            case 4: printf("(Priority)"); break;
+        i++;
+    }
+
+    if (feedback.boost < 0) {
+        fprintf(stderr, "--boost must not be negative\n");
+        return 1;
+    }
+    if (fair.latency < 1 || fair.min_granularity < 1) {
+        fprintf(stderr, "--latency and --min-granularity must be positive\n");
+        return 1;
+    }
+    if (smp.cpus < 1 || (smp.cpus > 1 && (choice < 1 || choice > 5) && choice != 12 && choice != 13)) {
+        fprintf(stderr, "--cpus needs a positive count and one of fcfs, sjf, rr, priority, srt, edf or rm\n");
+        return 1;
+    }
+    if (checkpoint.every < 0 || (checkpoint.every > 0 && checkpoint.save == NULL)) {
+        fprintf(stderr, "--checkpoint-every needs a non-negative count and --checkpoint\n");
+        return 1;
+    }
+    if ((checkpoint.save != NULL || resume != NULL) &&
+        (smp.cpus > 1 || replications > 1 || !((choice >= 1 && choice <= 5) || choice == 8 || choice == 9))) {
+        fprintf(stderr, "Checkpoints work with fcfs, sjf, rr, priority, srt, mlfq and cfs on one CPU\n");
+        return 1;
+    }
+    if (metrics_file != NULL && (replications > 1 || choice < 1 || (choice > 9 && choice < 12))) {
+        fprintf(stderr, "--metrics needs a single run of one of fcfs..cfs, edf or rm\n");
+        return 1;
+    }
+    if (results_file != NULL && (replications > 1 || choice < 1 || (choice > 9 && choice < 12) || choice == 6)) {
+        fprintf(stderr, "--results needs a single run of fcfs, sjf, rr, priority, srt, mlq, mlfq, cfs, edf\n"
+                        "or rm\n");
+        return 1;
+    }
+    if (stream_window >= 0 && (choice < 1 || choice > 5 || smp.cpus > 1 || replications > 1 ||
+                               write_trace != NULL || results_file != NULL || checkpoint.save != NULL ||
+                               resume != NULL)) {
+        fprintf(stderr, "--stream needs one of fcfs, sjf, rr, priority or srt on one CPU, without\n"
+                        "--write-trace, --results or checkpoints\n");
+        return 1;
+    }
+    if (gen.utilization > 0 && (stream_window >= 0 || replications > 1 || choice == 11)) {
+        fprintf(stderr, "--periodic doesn't work with --stream, --replications or bench\n");
+        return 1;
+    }
+    if (gen.devices > 0 && (input != NULL || gen.utilization > 0 || stream_window >= 0 || replications > 1 ||
+                            choice == 11)) {
+        fprintf(stderr, "--io needs --generate, without --periodic, --stream, --replications or bench\n");
+        return 1;
+    }
+    if (diff != NULL && summarize == NULL) {
+        fprintf(stderr, "--diff needs --summarize with the file to compare against\n");
+        return 1;
+    }
+    smp.seed = gen.seed;
+
+    // Results files are read on their own, without a workload
+    if (summarize != NULL)
+        return diff != NULL ? results_diff(summarize, diff) : results_report(summarize);
+
+    // The benchmark generates its own workloads
+    if (choice == 11) {
+        if (bench_max < 1000 || threshold < 0) {
+            fprintf(stderr, "--bench-max must be at least 1000 and --threshold non-negative\n");
+            return 1;
         }
-        printf(" ---\n");
-        
-        int start_time = current_time;
-        
-        // Execute the queue's algorithm
-        switch (queues[q].algorithm) {
-            case 1: // FCFS
-                {
-                   
-                    for (int i = 0; i < queue_size; i++) {
-                        if (current_time < queue_processes[i].arrival_time)
-                            current_time = queue_processes[i].arrival_time;
-                        
-                        printf("| P%d ", queue_processes[i].pid);
-                        queue_processes[i].waiting_time = current_time - queue_processes[i].arrival_time;
-                        current_time += queue_processes[i].burst_time;
-                        queue_processes[i].turnaround_time = queue_processes[i].waiting_time + queue_processes[i].burst_time;
-                    }
-                    printf("|\n");
-                }
-                break;
-                
-            case 2: // SJF (Non-preemptive)
-                {
-                    int completed = 0;
-                    int is_completed[MAX_PROCESSES] = {0};
-                    
-                    
-                    while (completed < queue_size) {
-                        int min_index = -1;
-                        int min_burst = INT_MAX;
-                        
-                        // Find process with shortest burst time that has arrived
-                        for (int i = 0; i < queue_size; i++) {
-                            if (!is_completed[i] && 
-                                queue_processes[i].arrival_time <= current_time &&
-                                queue_processes[i].burst_time < min_burst) {
-                                min_burst = queue_processes[i].burst_time;
-                                min_index = i;
-                            }
-                        }
-                        
-                        if (min_index == -1) {
-                            current_time++;
-                            continue;
-                        }
-                        
-                        printf("| P%d ", queue_processes[min_index].pid);
-                        queue_processes[min_index].waiting_time = current_time - queue_processes[min_index].arrival_time;
-                        current_time += queue_processes[min_index].burst_time;
-                        queue_processes[min_index].turnaround_time = current_time - queue_processes[min_index].arrival_time;
-                        is_completed[min_index] = 1;
-                        completed++;
-                    }
-                    printf("|\n");
-                }
-                break;
-                
-            case 3: // Round Robin
-                {
-                    int completed = 0;
-                    int remaining_bt[MAX_PROCESSES];
-                    
-                    for (int i = 0; i < queue_size; i++) {
-                        remaining_bt[i] = queue_processes[i].burst_time;
-                    }
-                    
-                  
-                    while (completed < queue_size) {
-                        int executed = 0;
-                        
-                        for (int i = 0; i < queue_size; i++) {
-                            if (queue_processes[i].arrival_time <= current_time && remaining_bt[i] > 0) {
-                                executed = 1;
-                                printf("| P%d ", queue_processes[i].pid);
-                                
-                                if (remaining_bt[i] > queues[q].quantum) {
-                                    current_time += queues[q].quantum;
-                                    remaining_bt[i] -= queues[q].quantum;
-                                } else {
-                                    current_time += remaining_bt[i];
-                                    queue_processes[i].turnaround_time = current_time - queue_processes[i].arrival_time;
-                                    queue_processes[i].waiting_time = queue_processes[i].turnaround_time - queue_processes[i].burst_time;
-                                    remaining_bt[i] = 0;
-                                    completed++;
-                                }
-                            }
-                        }
-                        
-                        if (!executed)
-                            current_time++;
-                    }
-                    printf("|\n");
-                }
-                break;
-                
-            case 4: // Priority (Non-preemptive)
-                {
-                    int completed = 0;
-                    int is_completed[MAX_PROCESSES] = {0};
-                    
-                    
-                    while (completed < queue_size) {
-                        int idx = -1;
-                        int min_priority = INT_MAX;
-                        
-                        // Find highest priority process that has arrived
-                        for (int i = 0; i < queue_size; i++) {
-                            if (!is_completed[i] && 
-                                queue_processes[i].arrival_time <= current_time &&
-                                queue_processes[i].priority < min_priority) {
-                                min_priority = queue_processes[i].priority;
-                                idx = i;
-                            }
-                        }
-                        
-                        if (idx == -1) {
-                            current_time++;
-                            continue;
-                        }
-                        
-                        printf("| P%d ", queue_processes[idx].pid);
-                        queue_processes[idx].waiting_time = current_time - queue_processes[idx].arrival_time;
-                        current_time += queue_processes[idx].burst_time;
-                        queue_processes[idx].turnaround_time = current_time - queue_processes[idx].arrival_time;
-                        is_completed[idx] = 1;
-                        completed++;
-                    }
-                    printf("|\n");
-                }
-                break;
+        return run_benchmark(&gen, bench_max, quantum > 0 ? quantum : 4, &feedback, &fair, baseline, save_baseline, threshold) > 0;
+    }
+
+    if ((input == NULL) == (gen.count <= 0) || (choice == 0 && write_trace == NULL)) {
+        if (input != NULL && gen.count > 0)
+            fprintf(stderr, "Use either --input or --generate, not both\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (choice != 0 && (choice < 1 || choice > 13)) {
+        fprintf(stderr, "Unknown algorithm\n");
+        return 1;
+    }
+    if ((choice == 3 || choice == 6) && quantum <= 0) {
+        fprintf(stderr, "Round Robin needs a positive --quantum\n");
+        return 1;
+    }
+    if (choice == 7 && queue_spec == NULL) {
+        fprintf(stderr, "Multilevel queue scheduling needs --queues\n");
+        return 1;
+    }
+    if (replications < 1 || (replications > 1 && (gen.count <= 0 || choice < 1 || choice > 9))) {
+        fprintf(stderr, "--replications needs --generate and one of fcfs..cfs\n");
+        return 1;
+    }
+
+    Queue *queues = NULL;
+    int num_queues = 0;
+    if (choice == 7) {
+        num_queues = parse_queues(queue_spec, &queues, 0);
+        if (num_queues < 0) {
+            free(queues);
+            return 1;
         }
-        
-        // Display process details for this queue
-        printf("\nPID\tArrival\tBurst\tWaiting\tTurnaround\n");
-        for (int i = 0; i < queue_size; i++) {
-            printf("%d\t%d\t%d\t%d\t%d\n", 
-                   queue_processes[i].pid, 
-                   queue_processes[i].arrival_time,
-                   queue_processes[i].burst_time, 
-                   queue_processes[i].waiting_time, 
-                   queue_processes[i].turnaround_time);
-        }
-        
-        // Calculate average for this queue
-        double total_waiting = 0, total_turnaround = 0;
-        for (int i = 0; i < queue_size; i++) {
-            total_waiting += queue_processes[i].waiting_time;
-            total_turnaround += queue_processes[i].turnaround_time;
+        gen.queues = num_queues;
+    }
+
+    if (stream_window >= 0)
+        return batch_stream(input, &gen, choice, quantum, stream_window, gantt_file, metrics_file);
+
+    if (replications > 1) {
+        run_replications(&gen, replications, choice, quantum, queues, num_queues, &feedback, &fair);
+        free(queues);
+        return 0;
+    }
+
+    ProcessTable table;
+    IoWorkload io;
+    double load_start = wall_clock();
+    table_init(&table);
+    io_init(&io, gen.devices);
+    if (input != NULL && load_trace(input, &table, &io) != 0) {
+        free(queues);
+        io_free(&io);
+        table_free(&table);
+        return 1;
+    }
+    if (input == NULL)
+        generate_workload(&table, &gen, 0);
+    if (input == NULL && gen.utilization > 0) {
+        int stretched = 0;
+        for (int i = 0; i < table.count; i++)
+            stretched += table.period[i] > gen.period_max;
+        if (stretched > 0)
+            fprintf(stderr, "Warning: %d of %d tasks have periods past %lld so their share of the utilization\n"
+                            "fits a burst of at least 1; raise MAX or lower the task count to avoid it\n",
+                    stretched, table.count, gen.period_max);
+    }
+    if (gen.devices > 0)
+        generate_io(&io, &table, &gen, 0);
+    double load_seconds = wall_clock() - load_start;
+    if (table.count == 0) {
+        fprintf(stderr, "Trace %s has no processes\n", input);
+        free(queues);
+        io_free(&io);
+        table_free(&table);
+        return 1;
+    }
+
+    // I/O bursts go through the single-CPU event loop, whole table only
+    int blocking = io.step_count > 0, status = 0;
+    if (blocking) {
+        int periodic = 0;
+        for (int i = 0; i < table.count; i++)
+            periodic |= table.period[i] > 0;
+        if (periodic || smp.cpus > 1 || write_trace != NULL || queue_sets != NULL ||
+            checkpoint.save != NULL || resume != NULL) {
+            fprintf(stderr, "Processes with I/O bursts can't be periodic, and don't work with --cpus,\n"
+                            "--write-trace, --queue-sets or checkpoints\n");
+            status = 1;
+        } else if ((choice < 1 || choice > 6) && choice != 10) {
+            fprintf(stderr, "Processes with I/O bursts run under fcfs, sjf, rr, priority, srt, all or sweep\n");
+            status = 1;
         }
-        printf("Average Waiting Time: %.2f\n", total_waiting / queue_size);
-        printf("Average Turnaround Time: %.2f\n", total_turnaround / queue_size);
-        
-        // Update original processes array with calculated times
-        for (int i = 0; i < queue_size; i++) {
-            int idx = queues[q].process_indices[i];
-            processes[idx].waiting_time = queue_processes[i].waiting_time;
-            processes[idx].turnaround_time = queue_processes[i].turnaround_time;
+    }
+
+    // The trace keeps the task set; the runs see its jobs
+    if (status == 0 && write_trace != NULL)
+        status = save_trace(write_trace, &table) != 0;
+    if (status == 0 && choice != 0)
+        status = release_tasks(&table, horizon, smp.cpus) != 0;
+
+    Checkpoint from;
+    if (status == 0 && resume != NULL) {
+        status = checkpoint_load(resume, &from) != 0;
+        if (status == 0)
+            checkpoint.resume = &from;
+    }
+
+    int *members = NULL;
+    if (status == 0 && choice == 7) {
+        int invalid = 0;
+        for (int i = 0; i < table.count; i++) {
+            if (table.queue[i] < 0 || table.queue[i] >= num_queues)
+                invalid++;
         }
+        if (invalid > 0)
+            fprintf(stderr, "%d processes had an invalid queue number and were assigned to Queue 0\n", invalid);
+
+        members = malloc(sizeof(int) * table.count);
+        group_by_queue(&table, queues, num_queues, members);
     }
-    
-    // Display overall statistics
-    printf("\n=== Overall Statistics ===\n");
-    print_averages(processes, n);
+
+    // A results file takes its chart from the segment file, so that is opened
+    // for reading back, or spooled to a temporary file if none was asked for
+    FILE *segments = NULL;
+    if (status == 0 && (gantt_file != NULL || results_file != NULL)) {
+        segments = gantt_file != NULL ? fopen(gantt_file, "w+b") : tmpfile();
+        if (segments == NULL) {
+            fprintf(stderr, "Cannot create Gantt file %s\n", gantt_file != NULL ? gantt_file : "(temporary)");
+            status = 1;
+        } else {
+            fwrite(GANTT_MAGIC, 1, sizeof(GANTT_MAGIC) - 1, segments);
+        }
+    }
+
+    if (status == 0 && choice == 10) {
+        SweepConfig *configs;
+        int count = build_sweep(quantum_range, queue_sets, &configs);
+        if (count < 0) {
+            status = 1;
+        } else {
+            run_sweep(&table, configs, count, blocking ? &io : NULL);
+            for (int i = 0; i < count; i++)
+                free(configs[i].queues);
+        }
+        free(configs);
+    } else if (status == 0 && choice != 0) {
+        // One entry per algorithm "all" runs; the others use the first
+        Metrics metrics[5];
+        Metrics *record = metrics_file != NULL ? metrics : NULL;
+        Chart chart;
+
+        memset(metrics, 0, sizeof(metrics));
+        Gantt *gantt = chart_open(&chart, gantt_text ? stdout : NULL, segments);
+        if (checkpoint.save != NULL || checkpoint.resume != NULL)
+            status = run_checkpointed(&table, choice, quantum, &feedback, &fair, &checkpoint, gantt, record);
+        else if (blocking && choice == 6)
+            run_all(&table, quantum, gantt, record, &io);
+        else if (blocking)
+            run_io_and_print(&table, &io, choice, quantum, gantt, record);
+        else
+            status = run_choice(&table, choice, quantum, queues, num_queues, members, &feedback, &fair, &smp, gantt, record);
+        chart_close(&chart);
+        if (status == 0 && results_file != NULL && results_save(results_file, &table, choice, segments, encoding) != 0)
+            status = 1;
+        if (record != NULL && metrics_save(metrics_file, metrics, 5, load_seconds) != 0)
+            status = 1;
+    }
+
+    if (segments != NULL && fclose(segments) != 0 && gantt_file != NULL) {
+        fprintf(stderr, "Error writing Gantt file %s\n", gantt_file);
+        status = 1;
+    }
+
+    if (checkpoint.resume != NULL)
+        checkpoint_free(&from);
+    free(members);
+    free(queues);
+    io_free(&io);
+    table_free(&table);
+    return status;
 }
 
-int main() {
+// ---------------------------------------------------------------------------
+// Interactive mode
+// ---------------------------------------------------------------------------
+
+int interactive_main(void) {
     int n, quantum = 0;
     int choice;
-    Process processes[MAX_PROCESSES];
+    ProcessTable table;
+    table_init(&table);
 
     printf("=== CPU Scheduling Simulator ===\n\n");
     printf("Enter the number of processes: ");
     scanf("%d", &n);
+    if (n <= 0) {
+        printf("\nNumber of processes must be positive.\n");
+        return 1;
+    }
+    table_reserve(&table, n);
 
     printf("\n--- Process Information ---\n");
     for (int i = 0; i < n; i++) {
-        processes[i].pid = i + 1;
+        SimTime arrival_time, burst_time;
         printf("Process %d:\n", i + 1);
         printf("  Arrival time: ");
-        scanf("%d", &processes[i].arrival_time);
+        scanf("%lld", &arrival_time);
         printf("  Burst time: ");
-        scanf("%d", &processes[i].burst_time);
-        processes[i].remaining_time = processes[i].burst_time;
-        processes[i].priority = 0; // Default priority
+        scanf("%lld", &burst_time);
+        table_add(&table, arrival_time, burst_time, 0); // Default priority
     }
 
     printf("\n=== Select Scheduling Algorithms ===\n");
@@ -449,9 +3611,17 @@ int main() {
     printf("5. Shortest Remaining Time (SRT)\n");
     printf("6. Run All Algorithms\n");
     printf("7. Multilevel Queue Scheduling\n");
-    printf("\nEnter your choice (1-7): ");
+    printf("8. Multilevel Feedback Queue (MLFQ)\n");
+    printf("9. Completely Fair Scheduler (CFS)\n");
+    printf("10. Earliest Deadline First (EDF)\n");
+    printf("11. Rate Monotonic (RM)\n");
+    printf("\nEnter your choice (1-11): ");
     scanf("%d", &choice);
 
+    // EDF and RM run as 12 and 13, past batch mode's sweep and bench
+    if (choice == 10 || choice == 11)
+        choice += 2;
+
     // Ask for quantum only if RR is selected
     if (choice == 3 || choice == 6) {
         printf("\nEnter time quantum for Round Robin: ");
@@ -463,19 +3633,25 @@ int main() {
         printf("\n--- Priority Information ---\n");
         for (int i = 0; i < n; i++) {
             printf("Enter priority for Process %d (lower number = higher priority): ", i + 1);
-            scanf("%d", &processes[i].priority);
+            scanf("%d", &table.priority[i]);
         }
     }
 
     // Multilevel Queue Configuration
-    Queue queues[MAX_PROCESSES];
+    Queue *queues = NULL;
+    int *members = NULL;
     int num_queues = 0;
-    
+
     if (choice == 7) {
         printf("\n=== Multilevel Queue Configuration ===\n");
         printf("Enter number of queues: ");
         scanf("%d", &num_queues);
-        
+        if (num_queues <= 0) {
+            printf("\nNumber of queues must be positive.\n");
+            return 1;
+        }
+        queues = malloc(sizeof(Queue) * num_queues);
+
         // Configure each queue
         for (int q = 0; q < num_queues; q++) {
             printf("\n--- Queue %d Configuration (Priority: %d = Highest) ---\n", q, q);
@@ -486,7 +3662,7 @@ int main() {
             printf("  4. Priority Scheduling\n");
             printf("Choice: ");
             scanf("%d", &queues[q].algorithm);
-            
+
             // Ask for quantum if RR is selected for this queue
             if (queues[q].algorithm == 3) {
                 printf("Enter time quantum for this queue: ");
@@ -494,10 +3670,8 @@ int main() {
             } else {
                 queues[q].quantum = 0;
             }
-            
-            queues[q].process_count = 0;
         }
-        
+
         // Ask for priority values if any queue uses Priority scheduling
         int need_priority = 0;
         for (int q = 0; q < num_queues; q++) {
@@ -506,75 +3680,129 @@ int main() {
                 break;
             }
         }
-        
+
         if (need_priority) {
             printf("\n--- Priority Information ---\n");
             for (int i = 0; i < n; i++) {
                 printf("Enter priority for Process %d (lower number = higher priority): ", i + 1);
-                scanf("%d", &processes[i].priority);
+                scanf("%d", &table.priority[i]);
             }
         }
-        
+
         // Assign processes to queues
         printf("\n--- Assign Processes to Queues ---\n");
         for (int i = 0; i < n; i++) {
             int queue_num;
             printf("Assign Process %d to which queue (0-%d)? ", i + 1, num_queues - 1);
             scanf("%d", &queue_num);
-            
+
             if (queue_num >= 0 && queue_num < num_queues) {
-                queues[queue_num].process_indices[queues[queue_num].process_count] = i;
-                queues[queue_num].process_count++;
+                table.queue[i] = queue_num;
             } else {
                 printf("Invalid queue number! Assigning to Queue 0.\n");
-                queues[0].process_indices[queues[0].process_count] = i;
-                queues[0].process_count++;
+                table.queue[i] = 0;
+            }
+        }
+
+        members = malloc(sizeof(int) * n);
+        group_by_queue(&table, queues, num_queues, members);
+    }
+
+    // Multilevel Feedback Queue Configuration
+    FeedbackConfig feedback = { 0, { 0 }, 0 };
+
+    if (choice == 8) {
+        printf("\n=== Multilevel Feedback Queue Configuration ===\n");
+        printf("Enter number of levels (1-%d): ", MLFQ_MAX_LEVELS);
+        scanf("%d", &feedback.num_levels);
+        if (feedback.num_levels <= 0 || feedback.num_levels > MLFQ_MAX_LEVELS) {
+            printf("\nNumber of levels must be between 1 and %d.\n", MLFQ_MAX_LEVELS);
+            return 1;
+        }
+
+        for (int l = 0; l < feedback.num_levels; l++) {
+            if (l + 1 == feedback.num_levels)
+                printf("Enter time quantum for level %d (0 = run to completion): ", l);
+            else
+                printf("Enter time quantum for level %d: ", l);
+            scanf("%lld", &feedback.quantum[l]);
+            if (feedback.quantum[l] < 0 || (feedback.quantum[l] == 0 && l + 1 < feedback.num_levels)) {
+                printf("\nInvalid time quantum.\n");
+                return 1;
+            }
+        }
+
+        printf("Enter boost period (0 = never): ");
+        scanf("%lld", &feedback.boost);
+        if (feedback.boost < 0)
+            feedback.boost = 0;
+    }
+
+    // Completely Fair Scheduler Configuration
+    FairConfig fair = { 24, 3 };
+
+    if (choice == 9) {
+        printf("\n=== Completely Fair Scheduler Configuration ===\n");
+        printf("Enter target latency: ");
+        scanf("%lld", &fair.latency);
+        printf("Enter minimum granularity: ");
+        scanf("%lld", &fair.min_granularity);
+        if (fair.latency < 1 || fair.min_granularity < 1) {
+            printf("\nLatency and granularity must be positive.\n");
+            return 1;
+        }
+
+        printf("\n--- Nice Values ---\n");
+        for (int i = 0; i < n; i++) {
+            printf("Enter nice value for Process %d (-20 to 19, lower = larger share): ", i + 1);
+            scanf("%d", &table.priority[i]);
+        }
+    }
+
+    // Real-time tasks: a period makes a process release a job every period
+    if (choice == 12 || choice == 13) {
+        printf("\n--- Deadlines and Periods ---\n");
+        for (int i = 0; i < n; i++) {
+            printf("Enter period for Process %d (0 = runs once): ", i + 1);
+            scanf("%lld", &table.period[i]);
+            printf("Enter relative deadline for Process %d (0 = none, or the period): ", i + 1);
+            scanf("%lld", &table.deadline[i]);
+            if (table.period[i] < 0 || table.deadline[i] < 0) {
+                printf("\nPeriods and deadlines must not be negative.\n");
+                return 1;
             }
         }
+        if (release_tasks(&table, 0, 1) != 0)
+            return 1;
     }
 
     printf("\n========================================\n");
 
     // Run selected algorithm(s)
-    switch (choice) {
-        case 1:
-            fcfs(processes, n);
-            break;
-        case 2:
-            sjf(processes, n);
-            break;
-        case 3:
-            rr(processes, n, quantum);
-            break;
-        case 4:
-            priority(processes, n);
-            break;
-        case 5:
-            srt(processes, n);
-            break;
-        case 6:
-            fcfs(processes, n);
-            printf("\n========================================\n");
-            sjf(processes, n);
-            printf("\n========================================\n");
-            rr(processes, n, quantum);
-            printf("\n========================================\n");
-            priority(processes, n);
-            printf("\n========================================\n");
-            srt(processes, n);
-            break;
-        case 7:
-            multilevel_queue(processes, n, queues, num_queues);
-            break;
-        default:
-            printf("\nInvalid choice! Please run the program again.\n");
-            return 1;
+    Chart chart;
+    Gantt *gantt = chart_open(&chart, stdout, NULL);
+    int invalid = run_choice(&table, choice, quantum, queues, num_queues, members, &feedback, &fair, NULL, gantt, NULL);
+    chart_close(&chart);
+    if (invalid) {
+        printf("\nInvalid choice! Please run the program again.\n");
+        return 1;
     }
 
+    free(members);
+    free(queues);
+    table_free(&table);
+
     printf("\n========================================\n");
     printf("\nPress Enter to exit...");
-    getchar(); 
-    getchar(); 
+    getchar();
+    getchar();
 
     return 0;
 }
+
+int main(int argc, char *argv[]) {
+    // Any command-line arguments select the non-interactive batch mode
+    if (argc > 1)
+        return batch_main(argc, argv);
+    return interactive_main();
+}
@@ -0,0 +1,3155 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <time.h>
+#endif
+
+#include "sched.h"
+
+// ---------------------------------------------------------------------------
+// Process table
+// ---------------------------------------------------------------------------
+
+// There is no way to report running out of memory from inside a simulation,
+// so the library gives up the way a failed assertion would
+static void *grow_array(void *array, size_t capacity, size_t size) {
+    void *grown = realloc(array, capacity * size);
+    if (grown == NULL)
+        abort();
+    return grown;
+}
+
+static void *xmalloc(size_t size) {
+    void *p = malloc(size);
+    if (p == NULL)
+        abort();
+    return p;
+}
+
+static void *xcalloc(size_t count, size_t size) {
+    void *p = calloc(count, size);
+    if (p == NULL)
+        abort();
+    return p;
+}
+
+void table_init(ProcessTable *t) {
+    t->count = 0;
+    t->capacity = 0;
+    t->shared = 0;
+    t->arrival_time = NULL;
+    t->remaining_time = NULL;
+    t->priority = NULL;
+    t->deadline = NULL;
+    t->period = NULL;
+    t->pid = NULL;
+    t->burst_time = NULL;
+    t->completion_time = NULL;
+    t->waiting_time = NULL;
+    t->turnaround_time = NULL;
+    t->response_time = NULL;
+    t->queue = NULL;
+}
+
+void table_reserve(ProcessTable *t, int capacity) {
+    if (capacity <= t->capacity)
+        return;
+
+    t->arrival_time = grow_array(t->arrival_time, (size_t)capacity, sizeof(SimTime));
+    t->remaining_time = grow_array(t->remaining_time, (size_t)capacity, sizeof(SimTime));
+    t->priority = grow_array(t->priority, (size_t)capacity, sizeof(int));
+    t->deadline = grow_array(t->deadline, (size_t)capacity, sizeof(SimTime));
+    t->period = grow_array(t->period, (size_t)capacity, sizeof(SimTime));
+    t->pid = grow_array(t->pid, (size_t)capacity, sizeof(int));
+    t->burst_time = grow_array(t->burst_time, (size_t)capacity, sizeof(SimTime));
+    t->completion_time = grow_array(t->completion_time, (size_t)capacity, sizeof(SimTime));
+    t->waiting_time = grow_array(t->waiting_time, (size_t)capacity, sizeof(SimTime));
+    t->turnaround_time = grow_array(t->turnaround_time, (size_t)capacity, sizeof(SimTime));
+    t->response_time = grow_array(t->response_time, (size_t)capacity, sizeof(SimTime));
+    t->queue = grow_array(t->queue, (size_t)capacity, sizeof(int));
+    t->capacity = capacity;
+}
+
+// Append a process and return its index; the table doubles as it fills
+int table_add(ProcessTable *t, SimTime arrival_time, SimTime burst_time, int priority) {
+    if (t->count == t->capacity)
+        table_reserve(t, t->capacity > 0 ? t->capacity * 2 : 64);
+
+    int i = t->count++;
+    t->pid[i] = i + 1;
+    t->arrival_time[i] = arrival_time;
+    t->burst_time[i] = burst_time;
+    t->remaining_time[i] = burst_time;
+    t->priority[i] = priority;
+    t->deadline[i] = 0;
+    t->period[i] = 0;
+    t->completion_time[i] = 0;
+    t->waiting_time[i] = 0;
+    t->turnaround_time[i] = 0;
+    t->response_time[i] = -1;
+    t->queue[i] = 0;
+    return i;
+}
+
+// Make dst a private copy of src for one simulation run. The input columns
+// (arrival, burst, priority, deadline, period, pid, queue) are shared
+// read-only with src; only the columns a run writes are allocated. src must
+// outlive dst.
+void table_fork(ProcessTable *dst, const ProcessTable *src) {
+    int n = src->count > 0 ? src->count : 1;
+
+    table_init(dst);
+    dst->count = src->count;
+    dst->capacity = src->count;
+    dst->shared = 1;
+    dst->arrival_time = src->arrival_time;
+    dst->priority = src->priority;
+    dst->deadline = src->deadline;
+    dst->period = src->period;
+    dst->pid = src->pid;
+    dst->burst_time = src->burst_time;
+    dst->queue = src->queue;
+    dst->remaining_time = grow_array(NULL, (size_t)n, sizeof(SimTime));
+    dst->completion_time = grow_array(NULL, (size_t)n, sizeof(SimTime));
+    dst->waiting_time = grow_array(NULL, (size_t)n, sizeof(SimTime));
+    dst->turnaround_time = grow_array(NULL, (size_t)n, sizeof(SimTime));
+    dst->response_time = grow_array(NULL, (size_t)n, sizeof(SimTime));
+}
+
+void table_free(ProcessTable *t) {
+    if (!t->shared) {
+        free(t->arrival_time);
+        free(t->priority);
+        free(t->deadline);
+        free(t->period);
+        free(t->pid);
+        free(t->burst_time);
+        free(t->queue);
+    }
+    free(t->remaining_time);
+    free(t->completion_time);
+    free(t->waiting_time);
+    free(t->turnaround_time);
+    free(t->response_time);
+    table_init(t);
+}
+
+// ---------------------------------------------------------------------------
+// Statistics
+// ---------------------------------------------------------------------------
+
+static int highest_bit(uint64_t bits) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(bits);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return (int)index;
+#else
+    int i = 0;
+    while (bits >>= 1)
+        i++;
+    return i;
+#endif
+}
+
+static int histogram_bucket(SimTime value) {
+    uint64_t v = value > 0 ? (uint64_t)value : 0;
+    if (v < HIST_SUB_COUNT)
+        return (int)v;
+
+    int shift = highest_bit(v) - HIST_SUB_BITS + 1;
+    return shift * (HIST_SUB_COUNT / 2) + (int)(v >> shift);
+}
+
+// Largest value that lands in the same bucket
+static SimTime histogram_bucket_top(int bucket) {
+    if (bucket < HIST_SUB_COUNT)
+        return bucket;
+
+    int shift = bucket / (HIST_SUB_COUNT / 2) - 1;
+    uint64_t low = (uint64_t)(bucket - shift * (HIST_SUB_COUNT / 2)) << shift;
+    return (SimTime)(low + ((1ULL << shift) - 1));
+}
+
+void histogram_init(Histogram *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = LLONG_MAX;
+    h->max = LLONG_MIN;
+}
+
+void histogram_add(Histogram *h, SimTime value) {
+    h->buckets[histogram_bucket(value)]++;
+    h->count++;
+    h->sum += (double)value;
+    if (value < h->min)
+        h->min = value;
+    if (value > h->max)
+        h->max = value;
+}
+
+void histogram_merge(Histogram *into, const Histogram *from) {
+    for (int b = 0; b < HIST_BUCKETS; b++)
+        into->buckets[b] += from->buckets[b];
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->min < into->min)
+        into->min = from->min;
+    if (from->max > into->max)
+        into->max = from->max;
+}
+
+double histogram_mean(const Histogram *h) {
+    return h->sum / (double)h->count;
+}
+
+// Bucket of the rank-th smallest sample (from 1)
+static int histogram_rank(const Histogram *h, long long rank) {
+    long long seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank)
+            return b;
+    }
+    return HIST_BUCKETS - 1;
+}
+
+static SimTime histogram_clamp(const Histogram *h, SimTime value) {
+    if (value > h->max)
+        value = h->max;
+    return value < h->min ? h->min : value;
+}
+
+static long long percentile_rank(long long count, double p) {
+    long long rank = (long long)ceil(p / 100 * (double)count);
+    return rank < 1 ? 1 : rank;
+}
+
+// Value at percentile p (0-100) by nearest rank, as the top of its bucket
+// clamped to the recorded range: exact below HIST_SUB_COUNT and for p = 100
+SimTime histogram_percentile(const Histogram *h, double p) {
+    if (h->count == 0)
+        return 0;
+    return histogram_clamp(h, histogram_bucket_top(histogram_rank(h, percentile_rank(h->count, p))));
+}
+
+void stats_init(Stats *s) {
+    histogram_init(&s->waiting);
+    histogram_init(&s->turnaround);
+    histogram_init(&s->response);
+    histogram_init(&s->early);
+    histogram_init(&s->late);
+}
+
+// Record a process that just completed. NULL turns statistics off.
+void stats_record(Stats *s, const ProcessTable *t, int idx) {
+    if (s == NULL)
+        return;
+    histogram_add(&s->waiting, t->waiting_time[idx]);
+    histogram_add(&s->turnaround, t->turnaround_time[idx]);
+    histogram_add(&s->response, t->response_time[idx]);
+    if (t->deadline[idx] > 0) {
+        SimTime lateness = t->completion_time[idx] - (t->arrival_time[idx] + t->deadline[idx]);
+        if (lateness > 0)
+            histogram_add(&s->late, lateness);
+        else
+            histogram_add(&s->early, -lateness);
+    }
+}
+
+void stats_merge(Stats *into, const Stats *from) {
+    histogram_merge(&into->waiting, &from->waiting);
+    histogram_merge(&into->turnaround, &from->turnaround);
+    histogram_merge(&into->response, &from->response);
+    histogram_merge(&into->early, &from->early);
+    histogram_merge(&into->late, &from->late);
+}
+
+// Mean lateness of the processes with a deadline, negative when they finish
+// early on average
+double lateness_mean(const Stats *s) {
+    return (s->late.sum - s->early.sum) / (double)(s->early.count + s->late.count);
+}
+
+// Lateness at percentile p (0-100) across both sides of the deadline. The
+// on-time processes come first, most early first, so a rank among them is
+// counted down from the top of `early`, whose bucket bottoms are the upper
+// ends of their lateness.
+SimTime lateness_percentile(const Stats *s, double p) {
+    long long count = s->early.count + s->late.count;
+    if (count == 0)
+        return 0;
+
+    long long rank = percentile_rank(count, p);
+    if (rank > s->early.count) {
+        int b = histogram_rank(&s->late, rank - s->early.count);
+        return histogram_clamp(&s->late, histogram_bucket_top(b));
+    }
+    int b = histogram_rank(&s->early, s->early.count - rank + 1);
+    return -histogram_clamp(&s->early, b > 0 ? histogram_bucket_top(b - 1) + 1 : 0);
+}
+
+// ---------------------------------------------------------------------------
+// Instrumentation
+// ---------------------------------------------------------------------------
+
+// Monotonic wall clock in seconds
+double wall_clock(void) {
+#ifdef _WIN32
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return (double)now.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+void metrics_init(Metrics *metrics, const char *algorithm) {
+    memset(metrics, 0, sizeof(*metrics));
+    strncpy(metrics->algorithm, algorithm, sizeof(metrics->algorithm) - 1);
+}
+
+// Add the counters of one engine run. NULL turns metrics off.
+void metrics_add(Metrics *into, const Metrics *from) {
+    if (into == NULL)
+        return;
+    into->dispatches += from->dispatches;
+    into->switches += from->switches;
+    into->preemptions += from->preemptions;
+    into->idle_jumps += from->idle_jumps;
+    into->idle_skipped += from->idle_skipped;
+    into->queue_pushes += from->queue_pushes;
+    into->queue_pops += from->queue_pops;
+    into->select_steps += from->select_steps;
+}
+
+// ---------------------------------------------------------------------------
+// Worker pool
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    void (*fn)(void *ctx, int i);
+    void *ctx;
+    int count;
+    int next;           // Next task index to hand out
+    pthread_mutex_t lock;
+} WorkQueue;
+
+// Set while a thread is running pool tasks, so nested parallel_for calls
+// run inline instead of multiplying threads
+static _Thread_local int in_pool;
+
+int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+#endif
+}
+
+static void *pool_worker(void *arg) {
+    WorkQueue *wq = arg;
+    int outer = in_pool;
+    in_pool = 1;
+
+    for (;;) {
+        pthread_mutex_lock(&wq->lock);
+        int i = wq->next++;
+        pthread_mutex_unlock(&wq->lock);
+
+        if (i >= wq->count)
+            break;
+        wq->fn(wq->ctx, i);
+    }
+
+    in_pool = outer;
+    return NULL;
+}
+
+// Run fn(ctx, i) for every i in [0, count) on up to one worker per core.
+// Workers pull the next task as they finish, so uneven tasks still balance.
+void parallel_for(int count, void (*fn)(void *ctx, int i), void *ctx) {
+    WorkQueue wq;
+    wq.fn = fn;
+    wq.ctx = ctx;
+    wq.count = count;
+    wq.next = 0;
+
+    int workers = in_pool ? 1 : cpu_count();
+    if (workers > count)
+        workers = count;
+
+    pthread_mutex_init(&wq.lock, NULL);
+    pthread_t *threads = xmalloc(sizeof(pthread_t) * (workers > 1 ? workers - 1 : 1));
+    int started = 0;
+    for (int w = 1; w < workers; w++) {
+        if (pthread_create(&threads[started], NULL, pool_worker, &wq) == 0)
+            started++;
+    }
+
+    pool_worker(&wq);   // The calling thread works too
+
+    for (int w = 0; w < started; w++)
+        pthread_join(threads[w], NULL);
+    free(threads);
+    pthread_mutex_destroy(&wq.lock);
+}
+
+// ---------------------------------------------------------------------------
+// Gantt chart
+// ---------------------------------------------------------------------------
+
+// Record into segments[capacity]; see Gantt. segments may be NULL with a
+// flush that grows the buffer.
+void gantt_init(Gantt *g, GanttSegment segments[], size_t capacity,
+                void (*flush)(Gantt *g, int end), void *ctx) {
+    g->segments = segments;
+    g->capacity = segments != NULL ? capacity : 0;
+    g->count = 0;
+    g->total = 0;
+    g->flush = flush;
+    g->ctx = ctx;
+    g->open = 0;
+}
+
+static void gantt_put(Gantt *g, int pid, SimTime start, SimTime end) {
+    if (g->count == g->capacity && g->flush != NULL)
+        g->flush(g, 0);
+    if (g->count < g->capacity) {
+        GanttSegment *s = &g->segments[g->count++];
+        s->pid = pid;
+        s->start = start;
+        s->end = end;
+    }
+    g->total++;
+}
+
+// Start a chart for one run with its marker segment
+void gantt_begin(Gantt *g, int algorithm, int level) {
+    if (g == NULL)
+        return;
+    gantt_put(g, 0, algorithm, level);
+    g->open = 0;
+}
+
+// Record that pid ran over [start, end). A slice that continues the previous
+// segment of the same process is merged into it.
+void gantt_record(Gantt *g, int pid, SimTime start, SimTime end) {
+    if (g == NULL)
+        return;
+
+    if (g->open && g->last.pid == pid && g->last.end == start) {
+        g->last.end = end;
+        return;
+    }
+    if (g->open)
+        gantt_put(g, g->last.pid, g->last.start, g->last.end);
+
+    g->last.pid = pid;
+    g->last.start = start;
+    g->last.end = end;
+    g->open = 1;
+}
+
+void gantt_end(Gantt *g) {
+    if (g == NULL)
+        return;
+    if (g->open)
+        gantt_put(g, g->last.pid, g->last.start, g->last.end);
+    g->open = 0;
+    if (g->flush != NULL)
+        g->flush(g, 1);
+}
+
+// Append a chart recorded by another Gantt (e.g. on another core), marker
+// included, as a run of this one
+void gantt_splice(Gantt *g, const GanttSegment segments[], size_t count) {
+    if (g == NULL)
+        return;
+    for (size_t i = 0; i < count; i++)
+        gantt_put(g, segments[i].pid, segments[i].start, segments[i].end);
+    if (g->flush != NULL)
+        g->flush(g, 1);
+}
+
+// Flush for a chart kept whole in memory: grow the buffer instead of draining it
+static void gantt_grow(Gantt *g, int end) {
+    if (end)
+        return;
+    g->capacity = g->capacity > 0 ? g->capacity * 2 : 1024;
+    g->segments = grow_array(g->segments, g->capacity, sizeof(GanttSegment));
+}
+
+// ---------------------------------------------------------------------------
+// Ready queues
+// ---------------------------------------------------------------------------
+
+void ready_init(ReadyQueue *rq, const ProcessTable *t, int capacity,
+                void (*push)(ReadyQueue *, int), int (*pop)(ReadyQueue *),
+                int (*before)(const ProcessTable *, int, int)) {
+    rq->push = push;
+    rq->pop = pop;
+    rq->table = t;
+    rq->items = xmalloc(sizeof(int) * (capacity > 0 ? capacity : 1));
+    rq->count = 0;
+    rq->capacity = capacity > 0 ? capacity : 1;
+    rq->head = 0;
+    rq->steps = 0;
+    rq->before = before;
+}
+
+void ready_free(ReadyQueue *rq) {
+    free(rq->items);
+    rq->items = NULL;
+}
+
+// Double a full queue. A ring that wraps past the end of the old array has
+// its wrapped front moved up behind the rest.
+static void ready_grow(ReadyQueue *rq) {
+    int capacity = rq->capacity;
+    rq->items = grow_array(rq->items, capacity * 2, sizeof(int));
+
+    int wrapped = rq->head + rq->count - capacity;
+    if (wrapped > 0)
+        memcpy(rq->items + capacity, rq->items, sizeof(int) * (size_t)wrapped);
+    rq->capacity = capacity * 2;
+}
+
+// FIFO ring buffer: O(1) push and pop. A process is in the ready queue at
+// most once, so a queue sized for every process never has to grow.
+void ring_push(ReadyQueue *rq, int idx) {
+    if (rq->count == rq->capacity)
+        ready_grow(rq);
+
+    int tail = rq->head + rq->count;
+    if (tail >= rq->capacity)
+        tail -= rq->capacity;
+    rq->items[tail] = idx;
+    rq->count++;
+}
+
+int ring_pop(ReadyQueue *rq) {
+    if (rq->count == 0)
+        return -1;
+
+    int idx = rq->items[rq->head];
+    if (++rq->head == rq->capacity)
+        rq->head = 0;
+    rq->count--;
+    return idx;
+}
+
+// Binary min-heap on rq->before: O(log n) push and pop
+void heap_push(ReadyQueue *rq, int idx) {
+    if (rq->count == rq->capacity)
+        ready_grow(rq);
+
+    int i = rq->count++;
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        METRIC(rq->steps++);
+        if (!rq->before(rq->table, idx, rq->items[parent]))
+            break;
+        rq->items[i] = rq->items[parent];
+        i = parent;
+    }
+    rq->items[i] = idx;
+}
+
+int heap_pop(ReadyQueue *rq) {
+    if (rq->count == 0)
+        return -1;
+
+    int top = rq->items[0];
+    int last = rq->items[--rq->count];
+    int i = 0;
+
+    // Sift the last element down from the root
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= rq->count)
+            break;
+        METRIC(rq->steps++);
+        if (child + 1 < rq->count && rq->before(rq->table, rq->items[child + 1], rq->items[child]))
+            child++;
+        if (!rq->before(rq->table, rq->items[child], last))
+            break;
+        rq->items[i] = rq->items[child];
+        i = child;
+    }
+    rq->items[i] = last;
+
+    return top;
+}
+
+static int lowest_bit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    int i = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+void feedback_init(FeedbackQueue *fq, int capacity, const FeedbackConfig *config, Gantt *gantt) {
+    int n = capacity > 0 ? capacity : 1;
+
+    fq->config = config;
+    fq->gantt = gantt;
+    fq->stats = NULL;
+    fq->checkpoint = NULL;
+    fq->metrics = NULL;
+    fq->nonempty = 0;
+    for (int l = 0; l < MLFQ_MAX_LEVELS; l++) {
+        fq->head[l] = -1;
+        fq->tail[l] = -1;
+    }
+    fq->next = xmalloc(sizeof(int) * n);
+    fq->used = xmalloc(sizeof(SimTime) * n);
+    fq->epoch = xmalloc(sizeof(int) * n);
+    fq->boosts = 0;
+    fq->dispatches = 0;
+}
+
+void feedback_free(FeedbackQueue *fq) {
+    free(fq->next);
+    free(fq->used);
+    free(fq->epoch);
+    fq->next = NULL;
+    fq->used = NULL;
+    fq->epoch = NULL;
+}
+
+void feedback_push(FeedbackQueue *fq, int idx, int level, SimTime used) {
+    fq->next[idx] = -1;
+    fq->used[idx] = used;
+    fq->epoch[idx] = fq->boosts;
+
+    if (fq->tail[level] == -1)
+        fq->head[level] = idx;
+    else
+        fq->next[fq->tail[level]] = idx;
+    fq->tail[level] = idx;
+    fq->nonempty |= 1ULL << level;
+}
+
+// Take the oldest process of the highest non-empty level. Returns -1 when
+// nothing is ready.
+int feedback_pop(FeedbackQueue *fq, int *level) {
+    if (fq->nonempty == 0)
+        return -1;
+
+    int l = lowest_bit(fq->nonempty);
+    int idx = fq->head[l];
+    fq->head[l] = fq->next[idx];
+    if (fq->head[l] == -1) {
+        fq->tail[l] = -1;
+        fq->nonempty &= ~(1ULL << l);
+    }
+
+    *level = l;
+    return idx;
+}
+
+// Priority boost: splice every level onto level 0, highest first, in
+// O(levels). Starting a new epoch resets every used quantum without visiting
+// the processes.
+void feedback_boost(FeedbackQueue *fq) {
+    for (int l = 1; l < fq->config->num_levels; l++) {
+        if (fq->head[l] == -1)
+            continue;
+        if (fq->tail[0] == -1)
+            fq->head[0] = fq->head[l];
+        else
+            fq->next[fq->tail[0]] = fq->head[l];
+        fq->tail[0] = fq->tail[l];
+        fq->head[l] = -1;
+        fq->tail[l] = -1;
+    }
+
+    if (fq->nonempty != 0)
+        fq->nonempty = 1;
+    fq->boosts++;
+}
+
+#define NICE_0_WEIGHT 1024
+
+// Load weight of a nice value (the priority field), as in Linux: each step
+// is worth about 10% of CPU time. Values outside -20..19 are clamped.
+static int nice_weight(int nice) {
+    static const int weights[40] = {
+        88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+        9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+        1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+        110, 87, 70, 56, 45, 36, 29, 23, 18, 15
+    };
+    if (nice < -20)
+        nice = -20;
+    if (nice > 19)
+        nice = 19;
+    return weights[nice + 20];
+}
+
+void fair_init(FairQueue *fq, int capacity, const FairConfig *config, Gantt *gantt) {
+    int n = capacity + 1;
+
+    fq->config = config;
+    fq->gantt = gantt;
+    fq->stats = NULL;
+    fq->checkpoint = NULL;
+    fq->metrics = NULL;
+    fq->vruntime = xmalloc(sizeof(double) * n);
+    fq->weight = xmalloc(sizeof(int) * n);
+    fq->left = xmalloc(sizeof(int) * n);
+    fq->right = xmalloc(sizeof(int) * n);
+    fq->parent = xmalloc(sizeof(int) * n);
+    fq->red = xmalloc((size_t)n);
+    fq->nil = capacity;
+    fq->red[fq->nil] = 0;
+    fq->root = fq->nil;
+    fq->leftmost = fq->nil;
+    fq->count = 0;
+    fq->total_weight = 0;
+    fq->min_vruntime = 0;
+    fq->dispatches = 0;
+    fq->steps = 0;
+}
+
+void fair_free(FairQueue *fq) {
+    free(fq->vruntime);
+    free(fq->weight);
+    free(fq->left);
+    free(fq->right);
+    free(fq->parent);
+    free(fq->red);
+    fq->vruntime = NULL;
+    fq->weight = NULL;
+    fq->left = fq->right = fq->parent = NULL;
+    fq->red = NULL;
+}
+
+// Equal virtual runtimes fall back to table order
+static int fair_before(const FairQueue *fq, int a, int b) {
+    if (fq->vruntime[a] != fq->vruntime[b])
+        return fq->vruntime[a] < fq->vruntime[b];
+    return a < b;
+}
+
+// Put v where u was under u's parent
+static void fair_replace(FairQueue *fq, int u, int v) {
+    int p = fq->parent[u];
+    if (p == fq->nil)
+        fq->root = v;
+    else if (u == fq->left[p])
+        fq->left[p] = v;
+    else
+        fq->right[p] = v;
+    fq->parent[v] = p;
+}
+
+static void fair_rotate_left(FairQueue *fq, int x) {
+    int y = fq->right[x];
+    fq->right[x] = fq->left[y];
+    if (fq->left[y] != fq->nil)
+        fq->parent[fq->left[y]] = x;
+    fair_replace(fq, x, y);
+    fq->left[y] = x;
+    fq->parent[x] = y;
+}
+
+static void fair_rotate_right(FairQueue *fq, int x) {
+    int y = fq->left[x];
+    fq->left[x] = fq->right[y];
+    if (fq->right[y] != fq->nil)
+        fq->parent[fq->right[y]] = x;
+    fair_replace(fq, x, y);
+    fq->right[y] = x;
+    fq->parent[x] = y;
+}
+
+void fair_insert(FairQueue *fq, int z) {
+    int y = fq->nil, x = fq->root;
+    int *left = fq->left, *right = fq->right, *parent = fq->parent;
+    char *red = fq->red;
+
+    while (x != fq->nil) {
+        y = x;
+        x = fair_before(fq, z, x) ? left[x] : right[x];
+        METRIC(fq->steps++);
+    }
+    parent[z] = y;
+    if (y == fq->nil)
+        fq->root = z;
+    else if (fair_before(fq, z, y))
+        left[y] = z;
+    else
+        right[y] = z;
+    left[z] = right[z] = fq->nil;
+    red[z] = 1;
+
+    if (fq->leftmost == fq->nil || fair_before(fq, z, fq->leftmost))
+        fq->leftmost = z;
+    fq->count++;
+    fq->total_weight += fq->weight[z];
+
+    while (red[parent[z]]) {
+        int p = parent[z], g = parent[p];
+        METRIC(fq->steps++);
+        if (p == left[g]) {
+            int uncle = right[g];
+            if (red[uncle]) {
+                red[p] = red[uncle] = 0;
+                red[g] = 1;
+                z = g;
+                continue;
+            }
+            if (z == right[p]) {
+                z = p;
+                fair_rotate_left(fq, z);
+                p = parent[z];
+            }
+            red[p] = 0;
+            red[g] = 1;
+            fair_rotate_right(fq, g);
+        } else {
+            int uncle = left[g];
+            if (red[uncle]) {
+                red[p] = red[uncle] = 0;
+                red[g] = 1;
+                z = g;
+                continue;
+            }
+            if (z == left[p]) {
+                z = p;
+                fair_rotate_right(fq, z);
+                p = parent[z];
+            }
+            red[p] = 0;
+            red[g] = 1;
+            fair_rotate_left(fq, g);
+        }
+    }
+    red[fq->root] = 0;
+}
+
+static int fair_minimum(const FairQueue *fq, int x) {
+    while (fq->left[x] != fq->nil)
+        x = fq->left[x];
+    return x;
+}
+
+void fair_erase(FairQueue *fq, int z) {
+    int *left = fq->left, *right = fq->right, *parent = fq->parent;
+    char *red = fq->red;
+    int x, y = z, y_red = red[z];
+
+    if (z == fq->leftmost)
+        fq->leftmost = right[z] != fq->nil ? fair_minimum(fq, right[z]) : parent[z];
+    fq->count--;
+    fq->total_weight -= fq->weight[z];
+
+    if (left[z] == fq->nil) {
+        x = right[z];
+        fair_replace(fq, z, x);
+    } else if (right[z] == fq->nil) {
+        x = left[z];
+        fair_replace(fq, z, x);
+    } else {
+        y = fair_minimum(fq, right[z]);
+        y_red = red[y];
+        x = right[y];
+        if (parent[y] == z) {
+            parent[x] = y;
+        } else {
+            fair_replace(fq, y, x);
+            right[y] = right[z];
+            parent[right[y]] = y;
+        }
+        fair_replace(fq, z, y);
+        left[y] = left[z];
+        parent[left[y]] = y;
+        red[y] = red[z];
+    }
+    if (y_red)
+        return;
+
+    while (x != fq->root && !red[x]) {
+        int p = parent[x];
+        METRIC(fq->steps++);
+        if (x == left[p]) {
+            int w = right[p];
+            if (red[w]) {
+                red[w] = 0;
+                red[p] = 1;
+                fair_rotate_left(fq, p);
+                w = right[p];
+            }
+            if (!red[left[w]] && !red[right[w]]) {
+                red[w] = 1;
+                x = p;
+                continue;
+            }
+            if (!red[right[w]]) {
+                red[left[w]] = 0;
+                red[w] = 1;
+                fair_rotate_right(fq, w);
+                w = right[p];
+            }
+            red[w] = red[p];
+            red[p] = 0;
+            red[right[w]] = 0;
+            fair_rotate_left(fq, p);
+        } else {
+            int w = left[p];
+            if (red[w]) {
+                red[w] = 0;
+                red[p] = 1;
+                fair_rotate_right(fq, p);
+                w = left[p];
+            }
+            if (!red[left[w]] && !red[right[w]]) {
+                red[w] = 1;
+                x = p;
+                continue;
+            }
+            if (!red[left[w]]) {
+                red[right[w]] = 0;
+                red[w] = 1;
+                fair_rotate_left(fq, w);
+                w = left[p];
+            }
+            red[w] = red[p];
+            red[p] = 0;
+            red[left[w]] = 0;
+            fair_rotate_right(fq, p);
+        }
+        x = fq->root;
+    }
+    red[x] = 0;
+}
+
+// Multilevel queue of process i, with unknown queues mapped to Queue 0
+static int queue_of(const ProcessTable *t, int i, int num_queues) {
+    return t->queue[i] >= 0 && t->queue[i] < num_queues ? t->queue[i] : 0;
+}
+
+// Orderings only touch hot fields until the keys are equal. Ties go to the
+// lower pid: table order for a loaded workload and input order for a stream,
+// whose table slots are reused.
+int arrival_before(const ProcessTable *t, int a, int b) {
+    if (t->arrival_time[a] != t->arrival_time[b])
+        return t->arrival_time[a] < t->arrival_time[b];
+    return t->pid[a] < t->pid[b];
+}
+
+int remaining_before(const ProcessTable *t, int a, int b) {
+    if (t->remaining_time[a] != t->remaining_time[b])
+        return t->remaining_time[a] < t->remaining_time[b];
+    return arrival_before(t, a, b);
+}
+
+int priority_before(const ProcessTable *t, int a, int b) {
+    if (t->priority[a] != t->priority[b])
+        return t->priority[a] < t->priority[b];
+    return arrival_before(t, a, b);
+}
+
+// Absolute deadline, with processes that have none after every one that does
+static SimTime absolute_deadline(const ProcessTable *t, int i) {
+    return t->deadline[i] > 0 ? t->arrival_time[i] + t->deadline[i] : LLONG_MAX;
+}
+
+int deadline_before(const ProcessTable *t, int a, int b) {
+    SimTime da = absolute_deadline(t, a), db = absolute_deadline(t, b);
+    if (da != db)
+        return da < db;
+    return arrival_before(t, a, b);
+}
+
+// Rate monotonic: shorter period first, one-shot processes last
+int period_before(const ProcessTable *t, int a, int b) {
+    uint64_t pa = (uint64_t)t->period[a] - 1, pb = (uint64_t)t->period[b] - 1;
+    if (pa != pb)
+        return pa < pb;
+    return arrival_before(t, a, b);
+}
+
+// ---------------------------------------------------------------------------
+// Checkpoints
+// ---------------------------------------------------------------------------
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * 1099511628211ULL;   // FNV-1a
+    return hash;
+}
+
+// Hash of the algorithm and every parameter that changes its schedule
+uint64_t checkpoint_settings(int algorithm, int quantum, const FeedbackConfig *feedback, const FairConfig *fair) {
+    uint64_t hash = hash_bytes(14695981039346656037ULL, &algorithm, sizeof(algorithm));
+
+    if (algorithm == 3)
+        hash = hash_bytes(hash, &quantum, sizeof(quantum));
+    if (algorithm == 8) {
+        hash = hash_bytes(hash, &feedback->num_levels, sizeof(feedback->num_levels));
+        hash = hash_bytes(hash, feedback->quantum, sizeof(SimTime) * feedback->num_levels);
+        hash = hash_bytes(hash, &feedback->boost, sizeof(feedback->boost));
+    }
+    if (algorithm == 9) {
+        hash = hash_bytes(hash, &fair->latency, sizeof(fair->latency));
+        hash = hash_bytes(hash, &fair->min_granularity, sizeof(fair->min_granularity));
+    }
+    return hash;
+}
+
+// Hash of the first count processes
+uint64_t checkpoint_fingerprint(const ProcessTable *t, int count) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < count; i++) {
+        hash = hash_bytes(hash, &t->arrival_time[i], sizeof(SimTime));
+        hash = hash_bytes(hash, &t->burst_time[i], sizeof(SimTime));
+        hash = hash_bytes(hash, &t->priority[i], sizeof(int));
+    }
+    return hash;
+}
+
+// Restore the process columns, clock and counters of a resumed run. Processes
+// the checkpoint saw finish are recorded in stats; the rest of the table
+// starts fresh. The engine refills its own ready queue from cp->ready.
+void checkpoint_restore(const Checkpoint *cp, ProcessTable *t, const int order[], Stats *stats,
+                        SimTime *time, int *next, int *completed) {
+    const CheckpointHeader *h = &cp->header;
+
+    for (int i = 0; i < t->count; i++) {
+        t->remaining_time[i] = t->burst_time[i];
+        t->response_time[i] = -1;
+    }
+    for (int k = 0; k < h->next; k++) {
+        int idx = order[k];
+        t->remaining_time[idx] = cp->remaining[idx];
+        t->response_time[idx] = cp->response[idx];
+        if (t->remaining_time[idx] == 0 && t->response_time[idx] >= 0) {
+            t->completion_time[idx] = cp->completion[idx];
+            t->turnaround_time[idx] = t->completion_time[idx] - t->arrival_time[idx];
+            t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+            stats_record(stats, t, idx);
+        }
+    }
+
+    *time = h->time;
+    *next = h->next;
+    *completed = h->completed;
+}
+
+// Whether the final arrivals are about to be admitted at time. A checkpoint
+// is always taken just before, the latest point a longer trace can resume
+// from, wherever the engine admits them: at the top of its loop or behind a
+// slice they cut short.
+static int checkpoint_arrivals_due(Checkpointer *cp, const ProcessTable *t, const int order[], int next,
+                                   SimTime time) {
+    if (cp == NULL || cp->save == NULL || cp->failed || cp->arrivals_saved)
+        return 0;
+
+    int n = t->count;
+    if (next < n && t->arrival_time[order[n - 1]] <= time) {
+        cp->arrivals_saved = 1;
+        return 1;
+    }
+    return 0;
+}
+
+// Whether to take a checkpoint at the top of the engine loop: before the
+// final arrivals, and every `every` slices if asked.
+int checkpoint_due(Checkpointer *cp, const ProcessTable *t, const int order[], int next,
+                   SimTime time, long long dispatches) {
+    if (checkpoint_arrivals_due(cp, t, order, next, time))
+        return 1;
+    if (cp == NULL || cp->save == NULL || cp->failed)
+        return 0;
+    if (cp->every > 0 && dispatches >= cp->due) {
+        cp->due = dispatches + cp->every;
+        return 1;
+    }
+    return 0;
+}
+
+// Header of a checkpoint at this point of the run; the engine fills in the rest
+void checkpoint_begin(CheckpointHeader *h, const Checkpointer *cp, const ProcessTable *t,
+                      SimTime time, int next, int completed, long long dispatches) {
+    memset(h, 0, sizeof(*h));
+    h->settings = cp->settings;
+    h->fingerprint = cp->fingerprint;
+    h->time = time;
+    h->dispatches = dispatches;
+    h->count = t->count;
+    h->next = next;
+    h->completed = completed;
+}
+
+// Store a checkpoint through cp->save and count it if it was stored
+static void checkpoint_store(Checkpointer *cp, const ProcessTable *t, const CheckpointHeader *h,
+                             const ReadyEntry ready[]) {
+    cp->save(cp, t, h, ready);
+    if (!cp->failed)
+        cp->saved++;
+}
+
+// Ready queue entries in dispatch order (any order for heaps, which sort them
+// again as they are pushed back). Caller frees.
+// Checkpoint the ready queue, with held (unless its idx is -1) after it as
+// the process to queue behind the arrivals at time
+static void ready_checkpoint(Checkpointer *cp, const ProcessTable *t, const ReadyQueue *rq, const ReadyEntry *held,
+                             SimTime time, int next, int completed, long long dispatches) {
+    CheckpointHeader h;
+    ReadyEntry *entries = xcalloc((size_t)rq->count + 1, sizeof(ReadyEntry));
+    for (int r = 0; r < rq->count; r++)
+        entries[r].idx = rq->items[(rq->head + r) % rq->capacity];
+
+    checkpoint_begin(&h, cp, t, time, next, completed, dispatches);
+    h.ready_count = rq->count;
+    if (held->idx >= 0) {
+        entries[h.ready_count++] = *held;
+        h.held = 1;
+    }
+    checkpoint_store(cp, t, &h, entries);
+    free(entries);
+}
+
+// ---------------------------------------------------------------------------
+// Event engine
+// ---------------------------------------------------------------------------
+
+// Stable merge sort of process indices by arrival time
+void sort_by_arrival(const ProcessTable *t, int order[], int n) {
+    int *tmp = xmalloc(sizeof(int) * (n > 0 ? n : 1));
+
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int i = lo, j = mid, k = lo;
+
+            while (i < mid && j < hi) {
+                if (t->arrival_time[order[j]] < t->arrival_time[order[i]])
+                    tmp[k++] = order[j++];
+                else
+                    tmp[k++] = order[i++];
+            }
+            while (i < mid) tmp[k++] = order[i++];
+            while (j < hi) tmp[k++] = order[j++];
+        }
+        for (int i = 0; i < n; i++)
+            order[i] = tmp[i];
+    }
+
+    free(tmp);
+}
+
+// Indices of every process in the table, sorted by arrival. Caller frees.
+static int *arrival_order(const ProcessTable *t) {
+    int n = t->count;
+    int *order = xmalloc(sizeof(int) * (n > 0 ? n : 1));
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    sort_by_arrival(t, order, n);
+    return order;
+}
+
+// Arrival as seen by a run that starts at start_time
+SimTime effective_arrival(const ProcessTable *t, int idx, SimTime start_time) {
+    return t->arrival_time[idx] < start_time ? start_time : t->arrival_time[idx];
+}
+
+// Shared discrete-event loop used by every algorithm. order[] holds the
+// processes to schedule sorted by arrival. Time only ever moves to the next
+// event: an arrival, a completion, or the end of a quantum, so idle gaps and
+// long bursts cost nothing. A run over the whole table from time 0 may
+// resume from and write checkpoints. Returns the time the last process finished.
+SimTime simulate(ProcessTable *t, const int order[], int n, SimTime start_time, Policy *policy) {
+    ReadyQueue *rq = policy->ready;
+    Checkpointer *cp = policy->checkpoint;
+    SimTime current_time = start_time;
+    int next = 0, completed = 0, last = -1;
+    ReadyEntry held = { -1, 0, 0, 0 };  // Goes back in after the arrivals at current_time
+    Metrics m;
+
+    if (cp != NULL && cp->resume != NULL) {
+        const CheckpointHeader *h = &cp->resume->header;
+        checkpoint_restore(cp->resume, t, order, policy->stats, &current_time, &next, &completed);
+        policy->dispatches = h->dispatches;
+        for (int r = 0; r < h->ready_count - h->held; r++)
+            rq->push(rq, cp->resume->ready[r].idx);
+        if (h->held)
+            held = cp->resume->ready[h->ready_count - 1];
+    } else {
+        for (int i = 0; i < n; i++) {
+            t->remaining_time[order[i]] = t->burst_time[order[i]];
+            t->response_time[order[i]] = -1;
+        }
+    }
+    // Counts the engine keeps anyway are taken as differences
+    METRIC(metrics_init(&m, ""); m.dispatches = -policy->dispatches; m.queue_pushes = -next; m.select_steps = -rq->steps);
+
+    while (completed < n) {
+        if (checkpoint_due(cp, t, order, next, current_time, policy->dispatches))
+            ready_checkpoint(cp, t, rq, &held, current_time, next, completed, policy->dispatches);
+
+        // Admit everything that has arrived by now
+        while (next < n && effective_arrival(t, order[next], start_time) <= current_time)
+            rq->push(rq, order[next++]);
+        if (held.idx >= 0) {
+            rq->push(rq, held.idx);
+            held.idx = -1;
+        }
+
+        int idx = rq->pop(rq);
+        if (idx == -1) {
+            // CPU idle: jump straight to the next arrival
+            METRIC(m.idle_jumps++; m.idle_skipped += effective_arrival(t, order[next], start_time) - current_time);
+            current_time = effective_arrival(t, order[next], start_time);
+            continue;
+        }
+
+        SimTime run = t->remaining_time[idx];
+        if (policy->quantum > 0 && run > policy->quantum)
+            run = policy->quantum;
+        if (policy->preemptive && next < n) {
+            SimTime until_arrival = effective_arrival(t, order[next], start_time) - current_time;
+            if (until_arrival < run)
+                run = until_arrival;
+        }
+
+        SimTime start = current_time;
+        current_time += run;
+        t->remaining_time[idx] -= run;
+        policy->dispatches++;
+        METRIC(m.switches += idx != last; last = idx);
+        if (t->response_time[idx] < 0)
+            t->response_time[idx] = start - effective_arrival(t, idx, start_time);
+
+        gantt_record(policy->gantt, t->pid[idx], start, current_time);
+
+        if (t->remaining_time[idx] == 0) {
+            t->completion_time[idx] = current_time;
+            t->turnaround_time[idx] = current_time - effective_arrival(t, idx, start_time);
+            t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+            stats_record(policy->stats, t, idx);
+            completed++;
+        } else {
+            // Arrivals during the slice queue up ahead of the preempted process
+            if (checkpoint_arrivals_due(cp, t, order, next, current_time)) {
+                ReadyEntry preempted = { idx, 0, 0, 0 };
+                ready_checkpoint(cp, t, rq, &preempted, current_time, next, completed, policy->dispatches);
+            }
+            while (next < n && effective_arrival(t, order[next], start_time) <= current_time)
+                rq->push(rq, order[next++]);
+            rq->push(rq, idx);
+            METRIC(m.preemptions++);
+        }
+    }
+
+    METRIC(m.dispatches += policy->dispatches; m.queue_pushes += next + m.preemptions;
+           m.queue_pops = m.dispatches + m.idle_jumps; m.select_steps += rq->steps;
+           metrics_add(policy->metrics, &m));
+    return current_time;
+}
+
+// FCFS runs every process to completion in arrival order, so completion
+// times follow c[i] = max(c[i - 1], arrival[i]) + burst[i]. Each step is the
+// max-plus map c -> max(c + burst, arrival + burst), and a run of steps
+// composes to c -> max(c + B, M) with B the run's total burst and M its last
+// completion had it started right away. The scan splits the processes into
+// one chunk per core, finds B and M for every chunk in parallel, carries
+// the start time across chunks serially, then replays each chunk from its
+// carry in parallel. The results match simulate() exactly.
+#define FCFS_SCAN_MIN_CHUNK (1 << 16)
+
+typedef struct {
+    ProcessTable *t;
+    const int *order;       // NULL when the table is already in arrival order
+    int n;
+    int chunks;
+    SimTime *total;         // [chunk] B: sum of bursts
+    SimTime *finish;        // [chunk] M: completion when started at once
+    SimTime *carry;         // [chunk] Time the chunk's first process may start
+    Stats *stats;           // [chunk], NULL = nowhere
+    Metrics *metrics;       // [chunk], idle gaps only
+} FcfsScan;
+
+static void fcfs_chunk(const FcfsScan *scan, int k, int *lo, int *hi) {
+    *lo = (int)((long long)scan->n * k / scan->chunks);
+    *hi = (int)((long long)scan->n * (k + 1) / scan->chunks);
+}
+
+static void fcfs_reduce(void *ctx, int k) {
+    FcfsScan *scan = ctx;
+    const SimTime *arrival = scan->t->arrival_time;
+    const SimTime *burst = scan->t->burst_time;
+    SimTime total = 0, finish = LLONG_MIN;
+    int lo, hi;
+
+    fcfs_chunk(scan, k, &lo, &hi);
+    for (int i = lo; i < hi; i++) {
+        int idx = scan->order != NULL ? scan->order[i] : i;
+        finish = (finish > arrival[idx] ? finish : arrival[idx]) + burst[idx];
+        total += burst[idx];
+    }
+    scan->total[k] = total;
+    scan->finish[k] = finish;
+}
+
+static void fcfs_replay(void *ctx, int k) {
+    FcfsScan *scan = ctx;
+    ProcessTable *t = scan->t;
+    SimTime c = scan->carry[k];
+    int lo, hi;
+
+    fcfs_chunk(scan, k, &lo, &hi);
+    if (scan->order == NULL) {
+        // Contiguous columns: the fix-up loop vectorizes
+        for (int i = lo; i < hi; i++) {
+            METRIC(Metrics *mk = &scan->metrics[k]; mk->idle_jumps += t->arrival_time[i] > c;
+                   mk->idle_skipped += t->arrival_time[i] > c ? t->arrival_time[i] - c : 0);
+            c = (c > t->arrival_time[i] ? c : t->arrival_time[i]) + t->burst_time[i];
+            t->completion_time[i] = c;
+        }
+        for (int i = lo; i < hi; i++) {
+            t->turnaround_time[i] = t->completion_time[i] - t->arrival_time[i];
+            t->waiting_time[i] = t->turnaround_time[i] - t->burst_time[i];
+            t->response_time[i] = t->waiting_time[i];
+            t->remaining_time[i] = 0;
+        }
+    } else {
+        for (int i = lo; i < hi; i++) {
+            int idx = scan->order[i];
+            METRIC(Metrics *mk = &scan->metrics[k]; mk->idle_jumps += t->arrival_time[idx] > c;
+                   mk->idle_skipped += t->arrival_time[idx] > c ? t->arrival_time[idx] - c : 0);
+            c = (c > t->arrival_time[idx] ? c : t->arrival_time[idx]) + t->burst_time[idx];
+            t->completion_time[idx] = c;
+            t->turnaround_time[idx] = c - t->arrival_time[idx];
+            t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+            t->response_time[idx] = t->waiting_time[idx];
+            t->remaining_time[idx] = 0;
+        }
+    }
+
+    if (scan->stats != NULL) {
+        for (int i = lo; i < hi; i++)
+            stats_record(&scan->stats[k], t, scan->order != NULL ? scan->order[i] : i);
+    }
+}
+
+static int arrival_sorted(const ProcessTable *t) {
+    for (int i = 1; i < t->count; i++) {
+        if (t->arrival_time[i] < t->arrival_time[i - 1])
+            return 0;
+    }
+    return 1;
+}
+
+// FCFS over the whole table by parallel scan, on up to policy->threads
+// threads. Returns the time the last process finished.
+SimTime simulate_fcfs_scan(ProcessTable *t, Policy *policy) {
+    FcfsScan scan;
+    int *order = arrival_sorted(t) ? NULL : arrival_order(t);
+    int chunks = t->count / FCFS_SCAN_MIN_CHUNK;
+
+    if (chunks > policy->threads)
+        chunks = policy->threads;
+    if (chunks < 1)
+        chunks = 1;
+
+    scan.t = t;
+    scan.order = order;
+    scan.n = t->count;
+    scan.chunks = chunks;
+    scan.total = xmalloc(sizeof(SimTime) * chunks);
+    scan.finish = xmalloc(sizeof(SimTime) * chunks);
+    scan.carry = xmalloc(sizeof(SimTime) * chunks);
+    scan.metrics = xcalloc((size_t)chunks, sizeof(Metrics));
+    scan.stats = NULL;
+    if (policy->stats != NULL) {
+        scan.stats = xmalloc(sizeof(Stats) * chunks);
+        for (int k = 0; k < chunks; k++)
+            stats_init(&scan.stats[k]);
+    }
+
+    // The first chunk's carry is all it needs, so it skips the reduce pass
+    SimTime c = 0;
+    if (chunks > 1)
+        parallel_for(chunks, fcfs_reduce, &scan);
+    for (int k = 0; k < chunks; k++) {
+        scan.carry[k] = c;
+        if (k < chunks - 1) {
+            SimTime shifted = c + scan.total[k];
+            c = shifted > scan.finish[k] ? shifted : scan.finish[k];
+        }
+    }
+    parallel_for(chunks, fcfs_replay, &scan);
+
+    SimTime end = 0;
+    if (t->count > 0)
+        end = t->completion_time[order != NULL ? order[t->count - 1] : t->count - 1];
+    if (scan.stats != NULL) {
+        for (int k = 0; k < chunks; k++)
+            stats_merge(policy->stats, &scan.stats[k]);
+        free(scan.stats);
+    }
+    policy->dispatches += t->count;
+
+    // Every process runs once, straight through, without a ready queue
+    for (int k = 0; k < chunks; k++) {
+        METRIC(Metrics *mk = &scan.metrics[k]; int lo, hi; fcfs_chunk(&scan, k, &lo, &hi);
+               mk->dispatches = mk->switches = hi - lo; metrics_add(policy->metrics, mk));
+    }
+    free(scan.metrics);
+    free(scan.total);
+    free(scan.finish);
+    free(scan.carry);
+    free(order);
+    return end;
+}
+
+// Run one algorithm over the whole table. FCFS takes the parallel scan
+// unless a chart is being recorded, which needs the slices in time order.
+SimTime simulate_all(ProcessTable *t, Policy *policy) {
+    int fifo = policy->ready->pop == ring_pop && policy->quantum == 0 && !policy->preemptive;
+    if (fifo && policy->checkpoint == NULL && policy->gantt == NULL)
+        return simulate_fcfs_scan(t, policy);
+
+    int *order = arrival_order(t);
+    SimTime end = simulate(t, order, t->count, 0, policy);
+
+    free(order);
+    return end;
+}
+
+// Checkpoint the feedback queue, with held (unless its idx is -1) after it
+// as the process to queue behind the arrivals and boost at time
+static void feedback_checkpoint(FeedbackQueue *fq, const ProcessTable *t, const ReadyEntry *held,
+                                SimTime time, int next, int completed, SimTime next_boost) {
+    CheckpointHeader h;
+    ReadyEntry *ready = xmalloc(sizeof(ReadyEntry) * (t->count > 0 ? t->count : 1));
+    int count = 0;
+
+    for (int l = 0; l < fq->config->num_levels; l++) {
+        for (int idx = fq->head[l]; idx != -1; idx = fq->next[idx], count++) {
+            ready[count].idx = idx;
+            ready[count].level = l;
+            ready[count].used = fq->epoch[idx] == fq->boosts ? fq->used[idx] : 0;
+            ready[count].vruntime = 0;
+        }
+    }
+    checkpoint_begin(&h, fq->checkpoint, t, time, next, completed, fq->dispatches);
+    h.next_boost = next_boost;
+    if (held->idx >= 0) {
+        ready[count++] = *held;
+        h.held = 1;
+    }
+    h.ready_count = count;
+    checkpoint_store(fq->checkpoint, t, &h, ready);
+    free(ready);
+}
+
+// Multilevel feedback queue on the same event model. Arrivals enter level 0
+// and preempt whatever runs below it, a process that uses up its level's
+// quantum drops one level, and every boost period everything goes back to
+// level 0 so long jobs can't starve. Returns the time the last process finished.
+SimTime simulate_feedback(ProcessTable *t, FeedbackQueue *fq) {
+    const FeedbackConfig *config = fq->config;
+    int n = t->count;
+    int *order = arrival_order(t);
+    SimTime current_time = 0;
+    SimTime next_boost = config->boost > 0 ? config->boost : LLONG_MAX;
+    Checkpointer *cp = fq->checkpoint;
+    int next = 0, completed = 0, last = -1;
+    ReadyEntry held = { -1, 0, 0, 0 };  // Goes back in after the arrivals and boost at current_time
+    Metrics m;
+
+    if (cp != NULL && cp->resume != NULL) {
+        const Checkpoint *from = cp->resume;
+        checkpoint_restore(from, t, order, fq->stats, &current_time, &next, &completed);
+        next_boost = from->header.next_boost;
+        fq->dispatches = from->header.dispatches;
+        for (int r = 0; r < from->header.ready_count - from->header.held; r++)
+            feedback_push(fq, from->ready[r].idx, from->ready[r].level, from->ready[r].used);
+        if (from->header.held)
+            held = from->ready[from->header.ready_count - 1];
+    } else {
+        for (int i = 0; i < n; i++) {
+            t->remaining_time[i] = t->burst_time[i];
+            t->response_time[i] = -1;
+        }
+    }
+    METRIC(metrics_init(&m, ""); m.dispatches = -fq->dispatches; m.queue_pushes = -next);
+
+    while (completed < n) {
+        if (checkpoint_due(cp, t, order, next, current_time, fq->dispatches))
+            feedback_checkpoint(fq, t, &held, current_time, next, completed, next_boost);
+
+        while (next < n && t->arrival_time[order[next]] <= current_time)
+            feedback_push(fq, order[next++], 0, 0);
+        if (current_time >= next_boost) {
+            feedback_boost(fq);
+            next_boost = (current_time / config->boost + 1) * config->boost;
+        }
+        if (held.idx >= 0) {
+            feedback_push(fq, held.idx, held.level, held.used);
+            held.idx = -1;
+        }
+
+        int level;
+        int idx = feedback_pop(fq, &level);
+        if (idx == -1) {
+            // CPU idle: jump straight to the next arrival
+            METRIC(m.idle_jumps++; m.idle_skipped += t->arrival_time[order[next]] - current_time);
+            current_time = t->arrival_time[order[next]];
+            continue;
+        }
+
+        SimTime used = fq->epoch[idx] == fq->boosts ? fq->used[idx] : 0;
+        SimTime quantum = config->quantum[level];
+        SimTime run = t->remaining_time[idx];
+        if (quantum > 0 && run > quantum - used)
+            run = quantum - used;
+        if (level > 0 && next < n && t->arrival_time[order[next]] - current_time < run)
+            run = t->arrival_time[order[next]] - current_time;
+        if (next_boost - current_time < run)
+            run = next_boost - current_time;
+
+        SimTime start = current_time;
+        current_time += run;
+        t->remaining_time[idx] -= run;
+        used += run;
+        fq->dispatches++;
+        METRIC(m.switches += idx != last; last = idx);
+        if (t->response_time[idx] < 0)
+            t->response_time[idx] = start - t->arrival_time[idx];
+
+        gantt_record(fq->gantt, t->pid[idx], start, current_time);
+
+        if (t->remaining_time[idx] == 0) {
+            t->completion_time[idx] = current_time;
+            t->turnaround_time[idx] = current_time - t->arrival_time[idx];
+            t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+            stats_record(fq->stats, t, idx);
+            completed++;
+            continue;
+        }
+
+        // Arrivals during the slice queue up ahead of the preempted process,
+        // which a boost now sends back to level 0
+        if (quantum > 0 && used >= quantum) {
+            if (level + 1 < config->num_levels)
+                level++;
+            used = 0;
+        }
+        int boost = current_time >= next_boost;
+        if (checkpoint_arrivals_due(cp, t, order, next, current_time)) {
+            ReadyEntry preempted = { idx, boost ? 0 : level, boost ? 0 : used, 0 };
+            feedback_checkpoint(fq, t, &preempted, current_time, next, completed, next_boost);
+        }
+        while (next < n && t->arrival_time[order[next]] <= current_time)
+            feedback_push(fq, order[next++], 0, 0);
+        if (boost) {
+            feedback_boost(fq);
+            next_boost = (current_time / config->boost + 1) * config->boost;
+            level = 0;
+            used = 0;
+        }
+        feedback_push(fq, idx, level, used);
+        METRIC(m.preemptions++);
+    }
+
+    METRIC(m.dispatches += fq->dispatches; m.queue_pushes += next + m.preemptions;
+           m.queue_pops = m.dispatches + m.idle_jumps; metrics_add(fq->metrics, &m));
+    free(order);
+    return current_time;
+}
+
+// Completely fair scheduling on the same event model. The process with the
+// least virtual runtime runs next, for its weighted share of the scheduling
+// period: the target latency, stretched to min_granularity per runnable
+// process when there are too many to fit. Virtual runtime advances by the
+// time run, scaled by NICE_0_WEIGHT / weight, so heavier (lower nice)
+// processes age slower and get more of the CPU. Arrivals start at the
+// current minimum virtual runtime. Returns the time the last process finished.
+SimTime simulate_fair(ProcessTable *t, FairQueue *fq) {
+    const FairConfig *config = fq->config;
+    int n = t->count;
+    int *order = arrival_order(t);
+    SimTime current_time = 0;
+    Checkpointer *cp = fq->checkpoint;
+    int next = 0, completed = 0, last = -1;
+    Metrics m;
+
+    if (cp != NULL && cp->resume != NULL) {
+        const Checkpoint *from = cp->resume;
+        checkpoint_restore(from, t, order, fq->stats, &current_time, &next, &completed);
+        fq->min_vruntime = from->header.min_vruntime;
+        fq->dispatches = from->header.dispatches;
+        for (int r = 0; r < from->header.ready_count; r++) {
+            int idx = from->ready[r].idx;
+            fq->weight[idx] = nice_weight(t->priority[idx]);
+            fq->vruntime[idx] = from->ready[r].vruntime;
+            fair_insert(fq, idx);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            t->remaining_time[i] = t->burst_time[i];
+            t->response_time[i] = -1;
+        }
+    }
+    METRIC(metrics_init(&m, ""); m.dispatches = -fq->dispatches; m.queue_pushes = -next; m.select_steps = -fq->steps);
+
+    while (completed < n) {
+        if (checkpoint_due(cp, t, order, next, current_time, fq->dispatches)) {
+            // Every process that has arrived and not finished is in the tree
+            CheckpointHeader h;
+            ReadyEntry *ready = xmalloc(sizeof(ReadyEntry) * (fq->count > 0 ? fq->count : 1));
+            int count = 0;
+            for (int k = 0; k < next; k++) {
+                int idx = order[k];
+                if (t->remaining_time[idx] > 0 || t->response_time[idx] < 0) {
+                    ready[count].idx = idx;
+                    ready[count].level = 0;
+                    ready[count].used = 0;
+                    ready[count++].vruntime = fq->vruntime[idx];
+                }
+            }
+            checkpoint_begin(&h, cp, t, current_time, next, completed, fq->dispatches);
+            h.min_vruntime = fq->min_vruntime;
+            h.ready_count = count;
+            checkpoint_store(cp, t, &h, ready);
+            free(ready);
+        }
+
+        while (next < n && t->arrival_time[order[next]] <= current_time) {
+            int idx = order[next++];
+            fq->weight[idx] = nice_weight(t->priority[idx]);
+            fq->vruntime[idx] = fq->min_vruntime;
+            fair_insert(fq, idx);
+        }
+
+        int idx = fq->leftmost;
+        if (idx == fq->nil) {
+            // CPU idle: jump straight to the next arrival
+            METRIC(m.idle_jumps++; m.idle_skipped += t->arrival_time[order[next]] - current_time);
+            current_time = t->arrival_time[order[next]];
+            continue;
+        }
+        fair_erase(fq, idx);
+
+        // The running process counts towards the period and the total weight
+        long long running = fq->count + 1;
+        SimTime period = config->latency;
+        if (running * config->min_granularity > period)
+            period = running * config->min_granularity;
+        double share = (double)period * fq->weight[idx] / (double)(fq->total_weight + fq->weight[idx]);
+        SimTime slice = (SimTime)ceil(share);
+        if (slice < config->min_granularity)
+            slice = config->min_granularity;
+
+        SimTime run = t->remaining_time[idx] < slice ? t->remaining_time[idx] : slice;
+        SimTime start = current_time;
+        current_time += run;
+        t->remaining_time[idx] -= run;
+        fq->vruntime[idx] += (double)run * NICE_0_WEIGHT / fq->weight[idx];
+        fq->dispatches++;
+        METRIC(m.switches += idx != last; last = idx);
+        if (t->response_time[idx] < 0)
+            t->response_time[idx] = start - t->arrival_time[idx];
+
+        gantt_record(fq->gantt, t->pid[idx], start, current_time);
+
+        // min_vruntime follows the smallest runnable vruntime but never goes back
+        double smallest = t->remaining_time[idx] > 0 ? fq->vruntime[idx] : HUGE_VAL;
+        if (fq->leftmost != fq->nil && fq->vruntime[fq->leftmost] < smallest)
+            smallest = fq->vruntime[fq->leftmost];
+        if (smallest != HUGE_VAL && smallest > fq->min_vruntime)
+            fq->min_vruntime = smallest;
+
+        if (t->remaining_time[idx] == 0) {
+            t->completion_time[idx] = current_time;
+            t->turnaround_time[idx] = current_time - t->arrival_time[idx];
+            t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+            stats_record(fq->stats, t, idx);
+            completed++;
+        } else {
+            fair_insert(fq, idx);
+            METRIC(m.preemptions++);
+        }
+    }
+
+    METRIC(m.dispatches += fq->dispatches; m.queue_pushes += next + m.preemptions;
+           m.queue_pops = m.dispatches + m.idle_jumps; m.select_steps += fq->steps;
+           metrics_add(fq->metrics, &m));
+    free(order);
+    return current_time;
+}
+
+// ---------------------------------------------------------------------------
+// Algorithms
+// ---------------------------------------------------------------------------
+
+// Set up the ready queue and policy for an algorithm (1=FCFS, 2=SJF, 3=RR,
+// 4=Priority, 5=SRT, 12=EDF, 13=RM). Non-preemptive SJF can key on remaining
+// time because a process is only ever selected before it has run.
+void policy_init(Policy *policy, ReadyQueue *rq, const ProcessTable *t, int capacity,
+                 int algorithm, int quantum, Gantt *gantt) {
+    policy->ready = rq;
+    policy->quantum = 0;
+    policy->preemptive = 0;
+    policy->gantt = gantt;
+    policy->stats = NULL;
+    policy->checkpoint = NULL;
+    policy->metrics = NULL;
+    policy->threads = 0;
+    policy->dispatches = 0;
+
+    switch (algorithm) {
+        case 1: // FCFS
+            ready_init(rq, t, capacity, ring_push, ring_pop, NULL);
+            break;
+        case 2: // SJF (Non-preemptive)
+            ready_init(rq, t, capacity, heap_push, heap_pop, remaining_before);
+            break;
+        case 3: // Round Robin
+            ready_init(rq, t, capacity, ring_push, ring_pop, NULL);
+            policy->quantum = quantum;
+            break;
+        case 4: // Priority (Non-preemptive)
+            ready_init(rq, t, capacity, heap_push, heap_pop, priority_before);
+            break;
+        case 12: // Earliest Deadline First
+            ready_init(rq, t, capacity, heap_push, heap_pop, deadline_before);
+            policy->preemptive = 1;
+            break;
+        case 13: // Rate Monotonic
+            ready_init(rq, t, capacity, heap_push, heap_pop, period_before);
+            policy->preemptive = 1;
+            break;
+        default: // SRT
+            ready_init(rq, t, capacity, heap_push, heap_pop, remaining_before);
+            policy->preemptive = 1;
+            break;
+    }
+}
+
+// Simulate one algorithm over the whole table without printing anything.
+// Completions go to stats and counters to metrics unless they are NULL.
+// FCFS may use up to threads threads; 0 keeps it on the calling thread.
+SimTime run_algorithm(ProcessTable *t, int algorithm, int quantum, Gantt *gantt, Stats *stats, Metrics *metrics,
+                      int threads) {
+    ReadyQueue rq;
+    Policy policy;
+    double start = 0;
+    policy_init(&policy, &rq, t, t->count, algorithm, quantum, gantt);
+    policy.stats = stats;
+    policy.metrics = metrics;
+    policy.threads = threads;
+
+    METRIC(if (metrics != NULL) start = wall_clock());
+    SimTime end = simulate_all(t, &policy);
+    METRIC(if (metrics != NULL) metrics->simulate_seconds += wall_clock() - start);
+
+    ready_free(&rq);
+    return end;
+}
+
+// Simulate a multilevel feedback queue without printing anything
+SimTime run_feedback(ProcessTable *t, const FeedbackConfig *config, Gantt *gantt, Stats *stats, Metrics *metrics) {
+    FeedbackQueue fq;
+    double start = 0;
+    feedback_init(&fq, t->count, config, gantt);
+    fq.stats = stats;
+    fq.metrics = metrics;
+
+    METRIC(if (metrics != NULL) start = wall_clock());
+    SimTime end = simulate_feedback(t, &fq);
+    METRIC(if (metrics != NULL) metrics->simulate_seconds += wall_clock() - start);
+
+    feedback_free(&fq);
+    return end;
+}
+
+// Simulate the completely fair scheduler without printing anything
+SimTime run_fair(ProcessTable *t, const FairConfig *config, Gantt *gantt, Stats *stats, Metrics *metrics) {
+    FairQueue fq;
+    double start = 0;
+    fair_init(&fq, t->count, config, gantt);
+    fq.stats = stats;
+    fq.metrics = metrics;
+
+    METRIC(if (metrics != NULL) start = wall_clock());
+    SimTime end = simulate_fair(t, &fq);
+    METRIC(if (metrics != NULL) metrics->simulate_seconds += wall_clock() - start);
+
+    fair_free(&fq);
+    return end;
+}
+
+// Run algorithm 1-5, 8 (MLFQ) or 9 (CFS) over the whole table, resuming from
+// and taking checkpoints as cp says. The caller checks that cp->resume fits
+// the table first. Check cp->failed afterwards for a checkpoint not saved.
+SimTime run_resumable(ProcessTable *t, int algorithm, int quantum, const FeedbackConfig *feedback,
+                      const FairConfig *fair, Checkpointer *cp, Gantt *gantt, Stats *stats, Metrics *metrics) {
+    SimTime end;
+    double start = 0;
+
+    cp->settings = checkpoint_settings(algorithm, quantum, feedback, fair);
+    cp->fingerprint = checkpoint_fingerprint(t, t->count);
+    cp->due = (cp->resume != NULL ? cp->resume->header.dispatches : 0) + cp->every;
+    cp->arrivals_saved = 0;
+    cp->saved = 0;
+    cp->failed = 0;
+
+    METRIC(if (metrics != NULL) start = wall_clock());
+    if (algorithm == 8) {
+        FeedbackQueue fq;
+        feedback_init(&fq, t->count, feedback, gantt);
+        fq.stats = stats;
+        fq.checkpoint = cp;
+        fq.metrics = metrics;
+        end = simulate_feedback(t, &fq);
+        feedback_free(&fq);
+    } else if (algorithm == 9) {
+        FairQueue fq;
+        fair_init(&fq, t->count, fair, gantt);
+        fq.stats = stats;
+        fq.checkpoint = cp;
+        fq.metrics = metrics;
+        end = simulate_fair(t, &fq);
+        fair_free(&fq);
+    } else {
+        ReadyQueue rq;
+        Policy policy;
+        policy_init(&policy, &rq, t, t->count, algorithm, quantum, gantt);
+        policy.stats = stats;
+        policy.checkpoint = cp;
+        policy.metrics = metrics;
+        end = simulate_all(t, &policy);
+        ready_free(&rq);
+    }
+    METRIC(if (metrics != NULL) metrics->simulate_seconds += wall_clock() - start);
+    return end;
+}
+
+// Lay out each queue's processes as one contiguous range of members[],
+// in arrival order, and record the range in the queue. Processes assigned
+// to a queue that doesn't exist go to Queue 0.
+void group_by_queue(const ProcessTable *t, Queue queues[], int num_queues, int members[]) {
+    int n = t->count;
+    int *order = arrival_order(t);
+
+    for (int q = 0; q < num_queues; q++)
+        queues[q].process_count = 0;
+    for (int i = 0; i < n; i++)
+        queues[queue_of(t, i, num_queues)].process_count++;
+
+    int first = 0;
+    for (int q = 0; q < num_queues; q++) {
+        queues[q].first = first;
+        first += queues[q].process_count;
+    }
+
+    int *fill = xcalloc(num_queues > 0 ? num_queues : 1, sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int q = queue_of(t, order[i], num_queues);
+        members[queues[q].first + fill[q]++] = order[i];
+    }
+
+    free(fill);
+    free(order);
+}
+
+// Simulate one queue of a multilevel configuration, starting once the
+// previous queue has drained. Returns the time its last process finished.
+SimTime run_queue(ProcessTable *t, const Queue *queue, int level, const int members[],
+                  SimTime start_time, Gantt *gantt, Stats *stats, Metrics *metrics) {
+    ReadyQueue rq;
+    Policy policy;
+    double start = 0;
+    policy_init(&policy, &rq, t, queue->process_count, queue->algorithm, queue->quantum, gantt);
+    policy.stats = stats;
+    policy.metrics = metrics;
+
+    METRIC(if (metrics != NULL) start = wall_clock());
+    gantt_begin(gantt, 7, level);
+    SimTime end = simulate(t, &members[queue->first], queue->process_count, start_time, &policy);
+    gantt_end(gantt);
+    METRIC(if (metrics != NULL) metrics->simulate_seconds += wall_clock() - start);
+
+    ready_free(&rq);
+    return end;
+}
+
+// Simulate a whole multilevel configuration without printing anything
+SimTime run_multilevel(ProcessTable *t, const Queue queues[], int num_queues, const int members[],
+                       Gantt *gantt, Stats *stats, Metrics *metrics) {
+    SimTime current_time = 0;
+
+    for (int q = 0; q < num_queues; q++) {
+        if (queues[q].process_count > 0)
+            current_time = run_queue(t, &queues[q], q, members, current_time, gantt, stats, metrics);
+    }
+    return current_time;
+}
+
+// ---------------------------------------------------------------------------
+// Periodic tasks
+// ---------------------------------------------------------------------------
+
+// Total utilization (burst / period) of the periodic tasks, with their
+// number in *tasks
+double utilization(const ProcessTable *t, int *tasks) {
+    double total = 0;
+    *tasks = 0;
+    for (int i = 0; i < t->count; i++) {
+        if (t->period[i] > 0) {
+            total += (double)t->burst_time[i] / (double)t->period[i];
+            (*tasks)++;
+        }
+    }
+    return total;
+}
+
+// Liu and Layland's bound: any `tasks` periodic tasks with deadlines equal to
+// their periods and at most this utilization are schedulable under RM
+double rm_bound(int tasks) {
+    return tasks > 0 ? tasks * (pow(2.0, 1.0 / tasks) - 1) : 1;
+}
+
+static SimTime gcd(SimTime a, SimTime b) {
+    while (b != 0) {
+        SimTime r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Least common multiple of the periods, after which the schedule of tasks
+// released together repeats. 0 without periodic tasks, -1 if over limit.
+SimTime hyperperiod(const ProcessTable *t, SimTime limit) {
+    SimTime lcm = 0;
+    for (int i = 0; i < t->count; i++) {
+        SimTime p = t->period[i];
+        if (p <= 0)
+            continue;
+        if (lcm == 0) {
+            lcm = p;
+            continue;
+        }
+        SimTime step = p / gcd(lcm, p);
+        if (lcm > limit / step)
+            return -1;
+        lcm *= step;
+    }
+    return lcm <= limit ? lcm : -1;
+}
+
+// Release times of the tasks' next jobs, in a min-heap of task indices
+typedef struct {
+    int *tasks;
+    SimTime *release;   // Indexed by task
+    int count;
+} ReleaseHeap;
+
+static int release_before(const ReleaseHeap *h, int a, int b) {
+    if (h->release[a] != h->release[b])
+        return h->release[a] < h->release[b];
+    return a < b;
+}
+
+static void release_sift_down(ReleaseHeap *h, int i) {
+    int task = h->tasks[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->count)
+            break;
+        if (child + 1 < h->count && release_before(h, h->tasks[child + 1], h->tasks[child]))
+            child++;
+        if (!release_before(h, h->tasks[child], task))
+            break;
+        h->tasks[i] = h->tasks[child];
+        i = child;
+    }
+    h->tasks[i] = task;
+}
+
+// Expand every periodic task into its jobs: the task's own row is the job
+// released at its arrival, and one more job is appended for each later
+// period that starts before horizon, in release order. A task without a
+// deadline gets its period. Jobs keep the task's period, which RM ranks them
+// by, so call this once. Returns the number of jobs added, or -1 (leaving the
+// table alone) if they would take it past INT_MAX processes.
+int release_jobs(ProcessTable *t, SimTime horizon) {
+    int n = t->count;
+    long long jobs = 0;
+    for (int i = 0; i < n; i++) {
+        if (t->period[i] > 0 && t->arrival_time[i] < horizon)
+            jobs += (horizon - 1 - t->arrival_time[i]) / t->period[i];
+        if (jobs > INT_MAX - n)
+            return -1;
+    }
+
+    ReleaseHeap h;
+    h.tasks = xmalloc(sizeof(int) * (n > 0 ? n : 1));
+    h.release = xmalloc(sizeof(SimTime) * (n > 0 ? n : 1));
+    h.count = 0;
+    for (int i = 0; i < n; i++) {
+        if (t->period[i] <= 0)
+            continue;
+        if (t->deadline[i] <= 0)
+            t->deadline[i] = t->period[i];
+        if (t->arrival_time[i] < horizon && t->period[i] < horizon - t->arrival_time[i]) {
+            h.release[i] = t->arrival_time[i] + t->period[i];
+            h.tasks[h.count++] = i;
+        }
+    }
+    for (int i = h.count / 2 - 1; i >= 0; i--)
+        release_sift_down(&h, i);
+
+    table_reserve(t, n + (int)jobs);
+    while (h.count > 0) {
+        int task = h.tasks[0];
+        SimTime release = h.release[task];
+        int j = table_add(t, release, t->burst_time[task], t->priority[task]);
+        t->deadline[j] = t->deadline[task];
+        t->period[j] = t->period[task];
+        t->queue[j] = t->queue[task];
+
+        if (t->period[task] < horizon - release)
+            h.release[task] = release + t->period[task];
+        else
+            h.tasks[0] = h.tasks[--h.count];
+        release_sift_down(&h, 0);
+    }
+
+    free(h.tasks);
+    free(h.release);
+    return (int)jobs;
+}
+
+// ---------------------------------------------------------------------------
+// Workload generator
+// ---------------------------------------------------------------------------
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng *rng, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < 4; i++)
+        rng->s[i] = splitmix64(&x);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// Uniform in (0, 1), never exactly 0 so it is safe to take the log of
+double rng_uniform(Rng *rng) {
+    return ((rng_next(rng) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+double rng_exponential(Rng *rng, double mean) {
+    return -mean * log(rng_uniform(rng));
+}
+
+static SimTime draw_burst(Rng *rng, const GeneratorConfig *g) {
+    double burst;
+
+    switch (g->burst_kind) {
+        case BURST_PARETO:
+            burst = g->burst_b / pow(rng_uniform(rng), 1.0 / g->burst_a);
+            break;
+        case BURST_BIMODAL:
+            burst = rng_exponential(rng, rng_uniform(rng) < g->burst_p ? g->burst_b : g->burst_a);
+            break;
+        default:
+            burst = rng_exponential(rng, g->burst_a);
+            break;
+    }
+
+    // Bursts are whole time units and never empty
+    if (burst > 1e15)
+        burst = 1e15;
+    return burst < 1 ? 1 : (SimTime)ceil(burst);
+}
+
+void generator_init(Generator *gen, const GeneratorConfig *g, uint64_t stream) {
+    gen->config = g;
+    rng_seed(&gen->rng, g->seed, stream);
+    gen->clock = 0;
+    gen->batch_left = 0;
+    gen->left = g->count;
+    gen->drawn = 0;
+    gen->utilization_left = g->utilization;
+}
+
+// Draw the next periodic task into slot i, released at time 0 with an
+// implicit deadline
+static void generator_next_task(Generator *gen, ProcessTable *t, int i) {
+    const GeneratorConfig *g = gen->config;
+
+    // UUniFast: the tasks after this one keep the utilization left times the
+    // largest of `after` uniform draws, and this one takes the rest
+    double share = gen->utilization_left;
+    long long after = g->count - ++gen->drawn;
+    if (after > 0) {
+        gen->utilization_left *= pow(rng_uniform(&gen->rng), 1.0 / (double)after);
+        share -= gen->utilization_left;
+    }
+
+    double low = log((double)g->period_min), high = log((double)g->period_max);
+    SimTime period = (SimTime)llround(exp(low + (high - low) * rng_uniform(&gen->rng)));
+    if (period < g->period_min)
+        period = g->period_min;
+    if (period > g->period_max)
+        period = g->period_max;
+    SimTime burst = (SimTime)llround(share * (double)period);
+
+    // A share too small for one unit at this period gets a burst of 1 and
+    // the period that keeps its utilization, even past period_max, rather
+    // than a burst rounded up to 1 that would inflate the total
+    if (share * (double)period < 1) {
+        double stretched = 1.0 / share;
+        period = stretched < 1e15 ? (SimTime)llround(stretched) : (SimTime)1e15;
+        burst = 1;
+    }
+
+    t->arrival_time[i] = 0;
+    t->burst_time[i] = burst;
+    t->deadline[i] = period;
+    t->period[i] = period;
+}
+
+// Draw the next process into slot i of the table
+void generator_next(Generator *gen, ProcessTable *t, int i) {
+    const GeneratorConfig *g = gen->config;
+
+    if (g->utilization > 0) {
+        generator_next_task(gen, t, i);
+    } else {
+        if (g->arrival_kind == ARRIVAL_BURSTY) {
+            if (gen->batch_left == 0) {
+                gen->clock += rng_exponential(&gen->rng, g->arrival_mean * g->batch_mean);
+                gen->batch_left = 1;
+                while (rng_uniform(&gen->rng) > 1.0 / g->batch_mean)
+                    gen->batch_left++;
+            }
+            gen->batch_left--;
+        } else {
+            gen->clock += rng_exponential(&gen->rng, g->arrival_mean);
+        }
+        t->arrival_time[i] = (SimTime)gen->clock;
+        t->burst_time[i] = draw_burst(&gen->rng, g);
+    }
+
+    t->remaining_time[i] = t->burst_time[i];
+    t->priority[i] = g->priorities > 1 ? (int)(rng_next(&gen->rng) % (uint64_t)g->priorities) : 0;
+    t->queue[i] = g->queues > 1 ? (int)(rng_next(&gen->rng) % (uint64_t)g->queues) : 0;
+}
+
+// Fill t with g->count processes from stream number `stream` of g->seed
+void generate_workload(ProcessTable *t, const GeneratorConfig *g, uint64_t stream) {
+    Generator gen;
+    generator_init(&gen, g, stream);
+    table_reserve(t, t->count + g->count);
+
+    for (int n = 0; n < g->count; n++)
+        generator_next(&gen, t, table_add(t, 0, 0, 0));
+}
+
+// Stream source drawing the generator's g->count processes
+int generator_read(void *source, ProcessTable *t, int i) {
+    Generator *gen = source;
+    if (gen->left == 0)
+        return 0;
+    generator_next(gen, t, i);
+    gen->left--;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Multi-core simulation
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    ReadyQueue ready;
+    Policy policy;
+    int running;            // -1 when idle
+    int last;               // Process of the previous slice, for metrics
+    SimTime slice_start;
+    SimTime slice_end;
+    Gantt gantt;            // Kept in memory, added to the run's chart per core afterwards
+    Gantt *chart;           // &gantt, or NULL when no chart is wanted
+} Core;
+
+// One M-CPU run. Busy cores sit in a min-heap on the end of their current
+// slice, so the next completion is found in O(log M).
+typedef struct Smp {
+    const SmpConfig *config;
+    ProcessTable *table;
+    Core *cores;
+    CoreStats *usage;
+    Stats *stats;           // Completions, NULL = nowhere
+    int *heap;              // Busy cores ordered by slice end
+    int *pos;               // Heap slot of each core, -1 when idle
+    int heap_count;
+    int idle;
+    int completed;
+    int next_core;          // PLACE_ROUND_ROBIN
+    Rng rng;                // PLACE_RANDOM
+    int (*place)(struct Smp *smp, int idx);
+    Metrics metrics;
+} Smp;
+
+static int place_round_robin(Smp *smp, int idx) {
+    (void)idx;
+    int c = smp->next_core;
+    smp->next_core = (c + 1) % smp->config->cpus;
+    return c;
+}
+
+static int core_load(const Smp *smp, int c) {
+    return smp->cores[c].ready.count + (smp->cores[c].running != -1);
+}
+
+static int place_least_loaded(Smp *smp, int idx) {
+    (void)idx;
+    int best = 0;
+    for (int c = 1; c < smp->config->cpus; c++) {
+        if (core_load(smp, c) < core_load(smp, best))
+            best = c;
+    }
+    return best;
+}
+
+static int place_random(Smp *smp, int idx) {
+    (void)idx;
+    return (int)(rng_next(&smp->rng) % (uint64_t)smp->config->cpus);
+}
+
+static int core_before(const Smp *smp, int a, int b) {
+    if (smp->cores[a].slice_end != smp->cores[b].slice_end)
+        return smp->cores[a].slice_end < smp->cores[b].slice_end;
+    return a < b;
+}
+
+static void core_heap_set(Smp *smp, int i, int c) {
+    smp->heap[i] = c;
+    smp->pos[c] = i;
+}
+
+static void core_heap_push(Smp *smp, int c) {
+    int i = smp->heap_count++;
+
+    while (i > 0 && core_before(smp, c, smp->heap[(i - 1) / 2])) {
+        core_heap_set(smp, i, smp->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    core_heap_set(smp, i, c);
+}
+
+static void core_heap_remove(Smp *smp, int c) {
+    int i = smp->pos[c];
+    int last = smp->heap[--smp->heap_count];
+    smp->pos[c] = -1;
+    if (last == c)
+        return;
+
+    // Put the last core in the hole and restore the order either way
+    while (i > 0 && core_before(smp, last, smp->heap[(i - 1) / 2])) {
+        core_heap_set(smp, i, smp->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= smp->heap_count)
+            break;
+        if (child + 1 < smp->heap_count && core_before(smp, smp->heap[child + 1], smp->heap[child]))
+            child++;
+        if (!core_before(smp, smp->heap[child], last))
+            break;
+        core_heap_set(smp, i, smp->heap[child]);
+        i = child;
+    }
+    core_heap_set(smp, i, last);
+}
+
+// Move one queued process from core `from` to core `to`
+static int migrate(Smp *smp, int from, int to) {
+    Core *source = &smp->cores[from];
+    int idx = source->ready.pop(&source->ready);
+    METRIC(smp->metrics.queue_pops++);
+    if (idx != -1) {
+        smp->cores[to].ready.push(&smp->cores[to].ready, idx);
+        smp->usage[to].migrations++;
+        METRIC(smp->metrics.queue_pushes++);
+    }
+    return idx;
+}
+
+// Take queued work from the most loaded core for an idle one
+static int steal(Smp *smp, int thief) {
+    int victim = -1;
+    for (int c = 0; c < smp->config->cpus; c++) {
+        if (smp->cores[c].ready.count > 0 && (victim == -1 || smp->cores[c].ready.count > smp->cores[victim].ready.count))
+            victim = c;
+    }
+    return victim != -1 ? migrate(smp, victim, thief) : -1;
+}
+
+// Start the next slice on an idle core, stealing if its own queue is empty
+static void core_dispatch(Smp *smp, int c, SimTime now) {
+    Core *core = &smp->cores[c];
+    if (core->ready.count == 0 && (smp->config->balance != BALANCE_STEAL || steal(smp, c) == -1))
+        return;
+
+    int idx = core->ready.pop(&core->ready);
+    SimTime run = smp->table->remaining_time[idx];
+    METRIC(smp->metrics.queue_pops++; smp->metrics.dispatches++;
+           smp->metrics.switches += idx != core->last; core->last = idx);
+    if (core->policy.quantum > 0 && run > core->policy.quantum)
+        run = core->policy.quantum;
+
+    core->running = idx;
+    core->slice_start = now;
+    core->slice_end = now + run;
+    if (smp->table->response_time[idx] < 0)
+        smp->table->response_time[idx] = now - smp->table->arrival_time[idx];
+    smp->usage[c].slices++;
+    smp->idle--;
+    core_heap_push(smp, c);
+}
+
+// End the running slice at `now`. Returns the process if it still has work,
+// or -1 once it has completed.
+static int core_stop(Smp *smp, int c, SimTime now) {
+    ProcessTable *t = smp->table;
+    Core *core = &smp->cores[c];
+    int idx = core->running;
+    SimTime run = now - core->slice_start;
+
+    t->remaining_time[idx] -= run;
+    smp->usage[c].busy += run;
+    gantt_record(core->chart, t->pid[idx], core->slice_start, now);
+
+    core_heap_remove(smp, c);
+    core->running = -1;
+    smp->idle++;
+
+    if (t->remaining_time[idx] > 0) {
+        METRIC(smp->metrics.preemptions++);
+        return idx;
+    }
+    t->completion_time[idx] = now;
+    t->turnaround_time[idx] = now - t->arrival_time[idx];
+    t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+    stats_record(smp->stats, t, idx);
+    smp->completed++;
+    return -1;
+}
+
+// Even out queued work: move processes from the most to the least loaded
+// core until no two cores differ by more than one
+static void rebalance(Smp *smp, SimTime now) {
+    for (;;) {
+        int most = -1, least = 0;
+        for (int c = 0; c < smp->config->cpus; c++) {
+            if (smp->cores[c].ready.count > 0 && (most == -1 || core_load(smp, c) > core_load(smp, most)))
+                most = c;
+            if (core_load(smp, c) < core_load(smp, least))
+                least = c;
+        }
+        if (most == -1 || core_load(smp, most) - core_load(smp, least) <= 1)
+            break;
+        migrate(smp, most, least);
+    }
+
+    for (int c = 0; c < smp->config->cpus && smp->idle > 0; c++) {
+        if (smp->cores[c].running == -1)
+            core_dispatch(smp, c, now);
+    }
+}
+
+// Simulate one algorithm (1=FCFS, 2=SJF, 3=RR, 4=Priority, 5=SRT, 12=EDF,
+// 13=RM) on config->cpus cores, each with its own ready queue, filling
+// usage[] per core, recording completions in stats and counters in metrics
+// unless they are NULL. Events at the same time are taken arrivals first, so a slice that
+// ends as processes arrive queues behind them as on one CPU. Each core's
+// chart goes to gantt as its own run. Returns the time the last process finished.
+SimTime run_multicore(ProcessTable *t, int algorithm, int quantum, const SmpConfig *config,
+                      Gantt *gantt, CoreStats usage[], Stats *stats, Metrics *metrics) {
+    int cpus = config->cpus, n = t->count;
+    int *order = arrival_order(t);
+    int *touched = xmalloc(sizeof(int) * cpus);
+    char *marked = xcalloc((size_t)cpus, 1);
+    int next = 0;
+    SimTime current_time = 0;
+    SimTime next_balance = config->balance == BALANCE_PERIODIC ? config->balance_period : LLONG_MAX;
+    Smp smp;
+
+    smp.config = config;
+    smp.table = t;
+    smp.cores = xmalloc(sizeof(Core) * cpus);
+    smp.usage = usage;
+    smp.stats = stats;
+    smp.heap = xmalloc(sizeof(int) * cpus);
+    smp.pos = xmalloc(sizeof(int) * cpus);
+    smp.heap_count = 0;
+    smp.idle = cpus;
+    smp.completed = 0;
+    smp.next_core = 0;
+    rng_seed(&smp.rng, config->seed, 0);
+    metrics_init(&smp.metrics, "");
+    smp.place = config->placement == PLACE_LEAST_LOADED ? place_least_loaded :
+                config->placement == PLACE_RANDOM ? place_random : place_round_robin;
+
+    for (int c = 0; c < cpus; c++) {
+        Core *core = &smp.cores[c];
+        policy_init(&core->policy, &core->ready, t, 64, algorithm, quantum, NULL);
+        core->running = -1;
+        core->last = -1;
+        gantt_init(&core->gantt, NULL, 0, gantt_grow, NULL);
+        core->chart = gantt != NULL ? &core->gantt : NULL;
+        gantt_begin(core->chart, algorithm, c);
+        usage[c].busy = 0;
+        usage[c].slices = 0;
+        usage[c].migrations = 0;
+        smp.pos[c] = -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        t->remaining_time[i] = t->burst_time[i];
+        t->response_time[i] = -1;
+    }
+
+    while (smp.completed < n) {
+        SimTime arrival = next < n ? t->arrival_time[order[next]] : LLONG_MAX;
+        SimTime slice_end = smp.heap_count > 0 ? smp.cores[smp.heap[0]].slice_end : LLONG_MAX;
+
+        if (next_balance < arrival && next_balance < slice_end) {
+            current_time = next_balance;
+            rebalance(&smp, current_time);
+            // Loads can't change before the next event, so skip the periods until then
+            SimTime upcoming = arrival < slice_end ? arrival : slice_end;
+            SimTime period = config->balance_period;
+            next_balance = current_time + period;
+            if (upcoming != LLONG_MAX && upcoming > next_balance)
+                next_balance = (upcoming - 1) / period * period + period;
+            continue;
+        }
+
+        if (arrival <= slice_end) {
+            // Queue everything arriving now, then let each affected core choose
+            int count = 0, backlog = 0;
+            METRIC(if (smp.heap_count == 0 && arrival > current_time) {
+                       smp.metrics.idle_jumps++;
+                       smp.metrics.idle_skipped += arrival - current_time;
+                   });
+            current_time = arrival;
+            while (next < n && t->arrival_time[order[next]] == current_time) {
+                int c = smp.place(&smp, order[next]);
+                Core *core = &smp.cores[c];
+                core->ready.push(&core->ready, order[next++]);
+                METRIC(smp.metrics.queue_pushes++);
+                if (!marked[c]) {
+                    marked[c] = 1;
+                    touched[count++] = c;
+                }
+            }
+            for (int k = 0; k < count; k++) {
+                int c = touched[k];
+                Core *core = &smp.cores[c];
+                marked[c] = 0;
+                if (core->running != -1 && core->policy.preemptive && core->slice_start < current_time) {
+                    int idx = core_stop(&smp, c, current_time);
+                    if (idx != -1) {
+                        core->ready.push(&core->ready, idx);
+                        METRIC(smp.metrics.queue_pushes++);
+                    }
+                }
+                if (core->running == -1)
+                    core_dispatch(&smp, c, current_time);
+                backlog |= core->ready.count > 0;
+            }
+            // Idle cores pull work that was queued on busy ones
+            for (int c = 0; c < cpus && backlog && smp.idle > 0 && config->balance == BALANCE_STEAL; c++) {
+                if (smp.cores[c].running == -1)
+                    core_dispatch(&smp, c, current_time);
+            }
+        } else {
+            int c = smp.heap[0];
+            Core *core = &smp.cores[c];
+            current_time = slice_end;
+            int idx = core_stop(&smp, c, current_time);
+            if (idx != -1) {
+                core->ready.push(&core->ready, idx);
+                METRIC(smp.metrics.queue_pushes++);
+            }
+            core_dispatch(&smp, c, current_time);
+        }
+    }
+
+    for (int c = 0; c < cpus; c++) {
+        Core *core = &smp.cores[c];
+        gantt_end(core->chart);
+        gantt_splice(gantt, core->gantt.segments, core->gantt.count);
+        free(core->gantt.segments);
+        METRIC(smp.metrics.select_steps += core->ready.steps);
+        ready_free(&core->ready);
+    }
+    METRIC(metrics_add(metrics, &smp.metrics));
+
+    free(smp.cores);
+    free(smp.heap);
+    free(smp.pos);
+    free(touched);
+    free(marked);
+    free(order);
+    return current_time;
+}
+
+// ---------------------------------------------------------------------------
+// I/O devices
+// ---------------------------------------------------------------------------
+
+void io_init(IoWorkload *io, int devices) {
+    io->devices = devices;
+    io->processes = 0;
+    io->capacity = 16;
+    io->first = grow_array(NULL, (size_t)io->capacity + 1, sizeof(int));
+    io->first[0] = 0;
+    io->steps = NULL;
+    io->step_count = 0;
+    io->step_capacity = 0;
+}
+
+void io_free(IoWorkload *io) {
+    free(io->first);
+    free(io->steps);
+    io->first = NULL;
+    io->steps = NULL;
+}
+
+// Give process i the bursts steps[count]. Processes are set in index order;
+// any skipped over have no steps.
+void io_set(IoWorkload *io, int i, const IoStep steps[], int count) {
+    if (i >= io->capacity) {
+        while (i >= io->capacity)
+            io->capacity *= 2;
+        io->first = grow_array(io->first, (size_t)io->capacity + 1, sizeof(int));
+    }
+    if (io->step_count + count > io->step_capacity) {
+        while (io->step_count + count > io->step_capacity)
+            io->step_capacity = io->step_capacity > 0 ? io->step_capacity * 2 : 64;
+        io->steps = grow_array(io->steps, (size_t)io->step_capacity, sizeof(IoStep));
+    }
+
+    while (io->processes < i)
+        io->first[++io->processes] = io->step_count;
+    if (count > 0)
+        memcpy(io->steps + io->step_count, steps, sizeof(IoStep) * count);
+    io->step_count += count;
+    io->first[++io->processes] = io->step_count;
+}
+
+// Number of steps of process i, 0 for a single CPU burst
+int io_count(const IoWorkload *io, int i) {
+    return i < io->processes ? io->first[i + 1] - io->first[i] : 0;
+}
+
+// Split every process of t into up to g->io_requests + 1 equal CPU bursts,
+// with a request to a random device between each two. Service times are
+// exponential with mean g->io_service. The draws have a stream of their own,
+// so the CPU demand is the same workload as without I/O.
+void generate_io(IoWorkload *io, const ProcessTable *t, const GeneratorConfig *g, uint64_t stream) {
+    IoStep *steps = grow_array(NULL, 2 * (size_t)g->io_requests + 1, sizeof(IoStep));
+    Rng rng;
+    rng_seed(&rng, g->seed ^ 0x5851F42D4C957F2DULL, stream);
+
+    for (int i = 0; i < t->count; i++) {
+        // Every CPU burst keeps at least one unit
+        SimTime burst = t->burst_time[i];
+        int requests = burst - 1 < g->io_requests ? (int)(burst > 1 ? burst - 1 : 0) : g->io_requests;
+        int count = 0;
+
+        for (int k = 0; k <= requests; k++) {
+            steps[count].device = -1;
+            steps[count++].time = burst * (k + 1) / (requests + 1) - burst * k / (requests + 1);
+            if (k < requests) {
+                double service = rng_exponential(&rng, g->io_service);
+                steps[count].device = (int)(rng_next(&rng) % (uint64_t)g->devices);
+                steps[count++].time = service < 1 ? 1 : (SimTime)ceil(service);
+            }
+        }
+        io_set(io, i, steps, requests > 0 ? count : 0);
+    }
+
+    free(steps);
+}
+
+// One run of simulate_io(). Each device queue is linked through link[] from
+// its request in service at head[d]; busy devices sit in a min-heap on when
+// that request completes, so every I/O completion costs O(log devices).
+typedef struct {
+    ProcessTable *t;
+    const IoWorkload *io;
+    ReadyQueue *ready;
+    IoUsage *usage;
+    int *order;
+    int n;
+    int next;               // Next arrival in order[]
+    int *step;              // Current step of each process, -1 for a single CPU burst
+    int *link;              // Next request in the same device queue
+    SimTime *since;         // When the process joined its ready or device queue
+    int head[IO_MAX_DEVICES];
+    int tail[IO_MAX_DEVICES];
+    int queued[IO_MAX_DEVICES];
+    SimTime done[IO_MAX_DEVICES];   // When the request in service completes
+    int heap[IO_MAX_DEVICES];
+    int busy;               // Devices in the heap
+} IoRun;
+
+static int device_before(const IoRun *r, int a, int b) {
+    return r->done[a] < r->done[b] || (r->done[a] == r->done[b] && a < b);
+}
+
+static void device_push(IoRun *r, int d) {
+    int i = r->busy++;
+    while (i > 0 && device_before(r, d, r->heap[(i - 1) / 2])) {
+        r->heap[i] = r->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    r->heap[i] = d;
+}
+
+static void device_pop(IoRun *r) {
+    int d = r->heap[--r->busy], i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= r->busy)
+            break;
+        if (child + 1 < r->busy && device_before(r, r->heap[child + 1], r->heap[child]))
+            child++;
+        if (!device_before(r, r->heap[child], d))
+            break;
+        r->heap[i] = r->heap[child];
+        i = child;
+    }
+    r->heap[i] = d;
+}
+
+// Start serving the request at the head of device d's queue
+static void device_start(IoRun *r, int d, SimTime now) {
+    int idx = r->head[d];
+    SimTime service = r->io->steps[r->step[idx]].time;
+    r->usage->devices[d].queued += now - r->since[idx];
+    r->usage->devices[d].busy += service;
+    r->done[d] = now + service;
+    device_push(r, d);
+}
+
+// Queue the request process idx has just reached
+static void device_request(IoRun *r, int idx, SimTime now) {
+    int d = r->io->steps[r->step[idx]].device;
+    DeviceStats *s = &r->usage->devices[d];
+
+    r->since[idx] = now;
+    r->link[idx] = -1;
+    if (r->queued[d]++ == 0) {
+        r->head[d] = idx;
+        device_start(r, d, now);
+    } else {
+        r->link[r->tail[d]] = idx;
+    }
+    r->tail[d] = idx;
+    s->requests++;
+    if (r->queued[d] > s->max_queue)
+        s->max_queue = r->queued[d];
+}
+
+// Finish the earliest request in service and make its process ready for
+// the CPU burst after it
+static void device_complete(IoRun *r) {
+    int d = r->heap[0], idx = r->head[d];
+    SimTime now = r->done[d];
+
+    device_pop(r);
+    r->head[d] = r->link[idx];
+    if (--r->queued[d] > 0)
+        device_start(r, d, now);
+
+    r->step[idx]++;
+    r->t->remaining_time[idx] = r->io->steps[r->step[idx]].time;
+    r->since[idx] = now;
+    r->ready->push(r->ready, idx);
+}
+
+// Time of the next arrival or I/O completion, LLONG_MAX if there is none
+static SimTime io_next_event(const IoRun *r) {
+    SimTime next = r->next < r->n ? r->t->arrival_time[r->order[r->next]] : LLONG_MAX;
+    if (r->busy > 0 && r->done[r->heap[0]] < next)
+        next = r->done[r->heap[0]];
+    return next;
+}
+
+// Queue every arrival and I/O completion up to `until` in time order,
+// arrivals first on ties
+static void io_admit(IoRun *r, SimTime until) {
+    for (;;) {
+        SimTime arrival = r->next < r->n ? r->t->arrival_time[r->order[r->next]] : LLONG_MAX;
+        if (r->busy > 0 && r->done[r->heap[0]] < arrival && r->done[r->heap[0]] <= until) {
+            device_complete(r);
+        } else if (arrival <= until) {
+            int idx = r->order[r->next++];
+            r->since[idx] = arrival;
+            r->ready->push(r->ready, idx);
+        } else {
+            break;
+        }
+    }
+}
+
+// The event loop of simulate() for processes that block on I/O. The CPU
+// scheduler only sees a process between its arrival or I/O completion and
+// the end of its CPU burst, and SJF and SRT order on what is left of the
+// current burst. A process's waiting time is what it spent in the ready
+// queue; time queued at devices goes to their statistics. Returns the time
+// the last process finished.
+SimTime simulate_io(ProcessTable *t, const IoWorkload *io, Policy *policy, IoUsage *usage) {
+    ReadyQueue *rq = policy->ready;
+    IoUsage own;
+    IoRun r;
+    SimTime current_time = 0;
+    int n = t->count, completed = 0, last = -1;
+    Metrics m;
+
+    r.t = t;
+    r.io = io;
+    r.ready = rq;
+    r.usage = usage != NULL ? usage : &own;
+    r.order = arrival_order(t);
+    r.n = n;
+    r.next = 0;
+    r.step = grow_array(NULL, (size_t)(n > 0 ? n : 1), sizeof(int));
+    r.link = grow_array(NULL, (size_t)(n > 0 ? n : 1), sizeof(int));
+    r.since = grow_array(NULL, (size_t)(n > 0 ? n : 1), sizeof(SimTime));
+    r.busy = 0;
+    memset(r.queued, 0, sizeof(r.queued));
+    memset(r.usage, 0, sizeof(IoUsage));
+
+    for (int i = 0; i < n; i++) {
+        r.step[i] = io_count(io, i) > 0 ? io->first[i] : -1;
+        t->remaining_time[i] = r.step[i] >= 0 ? io->steps[r.step[i]].time : t->burst_time[i];
+        t->waiting_time[i] = 0;
+        t->response_time[i] = -1;
+    }
+    METRIC(metrics_init(&m, ""); m.dispatches = -policy->dispatches; m.select_steps = -rq->steps);
+
+    while (completed < n) {
+        io_admit(&r, current_time);
+
+        int idx = rq->pop(rq);
+        if (idx == -1) {
+            // CPU idle: jump straight to the next arrival or I/O completion
+            SimTime next = io_next_event(&r);
+            METRIC(m.idle_jumps++; m.idle_skipped += next - current_time);
+            current_time = next;
+            continue;
+        }
+
+        SimTime run = t->remaining_time[idx];
+        if (policy->quantum > 0 && run > policy->quantum)
+            run = policy->quantum;
+        if (policy->preemptive) {
+            SimTime until_event = io_next_event(&r) - current_time;
+            if (until_event < run)
+                run = until_event;
+        }
+
+        SimTime start = current_time;
+        current_time += run;
+        t->remaining_time[idx] -= run;
+        t->waiting_time[idx] += start - r.since[idx];
+        r.usage->cpu_busy += run;
+        policy->dispatches++;
+        METRIC(m.switches += idx != last; last = idx);
+        if (t->response_time[idx] < 0)
+            t->response_time[idx] = start - t->arrival_time[idx];
+
+        gantt_record(policy->gantt, t->pid[idx], start, current_time);
+
+        // Arrivals and I/O completions during the slice queue up ahead of it
+        io_admit(&r, current_time);
+        if (t->remaining_time[idx] > 0) {
+            r.since[idx] = current_time;
+            rq->push(rq, idx);
+            METRIC(m.preemptions++);
+        } else if (r.step[idx] < 0 || r.step[idx] + 1 == io->first[idx + 1]) {
+            t->completion_time[idx] = current_time;
+            t->turnaround_time[idx] = current_time - t->arrival_time[idx];
+            stats_record(policy->stats, t, idx);
+            completed++;
+        } else {
+            r.step[idx]++;
+            device_request(&r, idx, current_time);
+        }
+    }
+
+    // Processes are pushed as they arrive, return from I/O or are preempted
+    METRIC(m.dispatches += policy->dispatches; m.queue_pushes = n + m.preemptions;
+           for (int d = 0; d < io->devices; d++) m.queue_pushes += r.usage->devices[d].requests;
+           m.queue_pops = m.dispatches + m.idle_jumps; m.select_steps += rq->steps;
+           metrics_add(policy->metrics, &m));
+
+    free(r.step);
+    free(r.link);
+    free(r.since);
+    free(r.order);
+    return current_time;
+}
+
+// Simulate algorithm 1-5 on one CPU over a workload that blocks on I/O,
+// without printing anything. usage gets the CPU's and every device's busy
+// time unless it is NULL.
+SimTime run_io(ProcessTable *t, const IoWorkload *io, int algorithm, int quantum, Gantt *gantt,
+               Stats *stats, Metrics *metrics, IoUsage *usage) {
+    ReadyQueue rq;
+    Policy policy;
+    double start = 0;
+    policy_init(&policy, &rq, t, t->count, algorithm, quantum, gantt);
+    policy.stats = stats;
+    policy.metrics = metrics;
+
+    METRIC(if (metrics != NULL) start = wall_clock());
+    SimTime end = simulate_io(t, io, &policy, usage);
+    METRIC(if (metrics != NULL) metrics->simulate_seconds += wall_clock() - start);
+
+    ready_free(&rq);
+    return end;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming
+// ---------------------------------------------------------------------------
+
+// Stream processes from read(source, ...), e.g. generator_read
+void stream_init(Stream *s, int (*read)(void *source, ProcessTable *t, int i), void *source) {
+    table_init(&s->table);
+    s->free_slots = NULL;
+    s->free_count = 0;
+    s->active = 0;
+    s->peak = 0;
+    s->admitted = 0;
+    s->last_arrival = 0;
+    s->out_of_order = -1;
+    s->read = read;
+    s->source = source;
+    s->finished = NULL;
+    s->ctx = NULL;
+}
+
+void stream_free(Stream *s) {
+    table_free(&s->table);
+    free(s->free_slots);
+    s->free_slots = NULL;
+}
+
+// Read the next process into a free slot. Returns the slot, STREAM_END once
+// the input is exhausted or STREAM_ERROR if it is malformed or out of order.
+static int stream_read(Stream *s) {
+    ProcessTable *t = &s->table;
+
+    int i;
+    if (s->free_count > 0) {
+        i = s->free_slots[--s->free_count];
+    } else {
+        int capacity = t->capacity;
+        i = table_add(t, 0, 0, 0);
+        if (t->capacity != capacity)
+            s->free_slots = grow_array(s->free_slots, (size_t)t->capacity, sizeof(int));
+    }
+
+    t->deadline[i] = 0;
+    t->period[i] = 0;
+    int status = s->read(s->source, t, i);
+    int late = status > 0 && t->arrival_time[i] < s->last_arrival;
+    if (status <= 0 || late) {
+        // Nothing was admitted, so the slot and the counters are as they were
+        s->free_slots[s->free_count++] = i;
+        if (late)
+            s->out_of_order = t->arrival_time[i];
+        return status == 0 ? STREAM_END : STREAM_ERROR;
+    }
+
+    // Pids number the processes in input order, wrapping past INT_MAX
+    t->remaining_time[i] = t->burst_time[i];
+    t->pid[i] = (int)(s->admitted++ % INT_MAX) + 1;
+    t->response_time[i] = -1;
+    if (++s->active > s->peak)
+        s->peak = s->active;
+    s->last_arrival = t->arrival_time[i];
+    return i;
+}
+
+static void stream_release(Stream *s, int idx) {
+    if (s->finished != NULL)
+        s->finished(s->ctx, &s->table, idx, s->active);
+    s->free_slots[s->free_count++] = idx;
+    s->active--;
+}
+
+// The event loop of simulate() over a stream, reading each process when the
+// clock reaches the one before it. Returns the time the last process
+// finished, or -1 if the input was bad.
+SimTime simulate_stream(Stream *s, Policy *policy) {
+    ProcessTable *t = &s->table;
+    ReadyQueue *rq = policy->ready;
+    SimTime current_time = 0;
+    int next = stream_read(s), last = -1;
+    Metrics m;
+
+    METRIC(metrics_init(&m, ""); m.dispatches = -policy->dispatches; m.select_steps = -rq->steps);
+
+    for (;;) {
+        // Admit everything that has arrived by now
+        while (next >= 0 && t->arrival_time[next] <= current_time) {
+            rq->push(rq, next);
+            METRIC(m.queue_pushes++);
+            next = stream_read(s);
+        }
+        if (next == STREAM_ERROR)
+            break;
+
+        int idx = rq->pop(rq);
+        if (idx == -1) {
+            if (next == STREAM_END)
+                break;
+            // CPU idle: jump straight to the next arrival
+            METRIC(m.idle_jumps++; m.idle_skipped += t->arrival_time[next] - current_time);
+            current_time = t->arrival_time[next];
+            continue;
+        }
+
+        SimTime run = t->remaining_time[idx];
+        if (policy->quantum > 0 && run > policy->quantum)
+            run = policy->quantum;
+        if (policy->preemptive && next >= 0 && t->arrival_time[next] - current_time < run)
+            run = t->arrival_time[next] - current_time;
+
+        SimTime start = current_time;
+        current_time += run;
+        t->remaining_time[idx] -= run;
+        policy->dispatches++;
+        METRIC(m.switches += t->pid[idx] != last; last = t->pid[idx]);
+        if (t->response_time[idx] < 0)
+            t->response_time[idx] = start - t->arrival_time[idx];
+
+        gantt_record(policy->gantt, t->pid[idx], start, current_time);
+
+        if (t->remaining_time[idx] == 0) {
+            t->completion_time[idx] = current_time;
+            t->turnaround_time[idx] = current_time - t->arrival_time[idx];
+            t->waiting_time[idx] = t->turnaround_time[idx] - t->burst_time[idx];
+            stats_record(policy->stats, t, idx);
+            stream_release(s, idx);
+        } else {
+            // Arrivals during the slice queue up ahead of the preempted process
+            while (next >= 0 && t->arrival_time[next] <= current_time) {
+                rq->push(rq, next);
+                METRIC(m.queue_pushes++);
+                next = stream_read(s);
+            }
+            rq->push(rq, idx);
+            METRIC(m.preemptions++);
+        }
+    }
+
+    METRIC(m.dispatches += policy->dispatches; m.queue_pushes += m.preemptions;
+           m.queue_pops = m.dispatches + m.idle_jumps; m.select_steps += rq->steps;
+           metrics_add(policy->metrics, &m));
+    return next == STREAM_ERROR ? -1 : current_time;
+}
+
+// ---------------------------------------------------------------------------
+// Library interface
+// ---------------------------------------------------------------------------
+
+static int valid_config(const SchedConfig *c, int count) {
+    switch (c->algorithm) {
+        case 1: case 2: case 4: case 5: case 12: case 13:
+            break;
+        case 3:
+            if (c->quantum <= 0)
+                return 0;
+            break;
+        case 7:
+            if (c->queues == NULL || c->num_queues <= 0)
+                return 0;
+            for (int q = 0; q < c->num_queues; q++) {
+                const Queue *queue = &c->queues[q];
+                if (queue->algorithm < 1 || queue->algorithm > 4 || (queue->algorithm == 3 && queue->quantum <= 0))
+                    return 0;
+            }
+            break;
+        case 8:
+            if (c->feedback.num_levels < 1 || c->feedback.num_levels > MLFQ_MAX_LEVELS || c->feedback.boost < 0)
+                return 0;
+            for (int l = 0; l < c->feedback.num_levels; l++) {
+                if (c->feedback.quantum[l] < 0 || (c->feedback.quantum[l] == 0 && l < c->feedback.num_levels - 1))
+                    return 0;
+            }
+            break;
+        case 9:
+            if (c->fair.latency < 1 || c->fair.min_granularity < 1)
+                return 0;
+            break;
+        default:
+            return 0;
+    }
+
+    if (c->smp.cpus > 1) {
+        if ((c->algorithm > 5 && c->algorithm < 12) || c->smp.placement < PLACE_ROUND_ROBIN || c->smp.placement > PLACE_RANDOM ||
+            c->smp.balance < BALANCE_NONE || c->smp.balance > BALANCE_PERIODIC ||
+            (c->smp.balance == BALANCE_PERIODIC && c->smp.balance_period <= 0))
+            return 0;
+    }
+    return c->threads >= 0 && count >= 0;
+}
+
+int sched_run(const SchedWorkload *workload, const SchedConfig *config, SchedResults *results) {
+    int n = workload->count;
+    if (!valid_config(config, n) || workload->arrival_time == NULL || workload->burst_time == NULL ||
+        results->completion_time == NULL || results->waiting_time == NULL ||
+        results->turnaround_time == NULL || results->response_time == NULL)
+        return -1;
+    for (int i = 0; i < n; i++) {
+        if (workload->arrival_time[i] < 0 || workload->burst_time[i] < 0)
+            return -1;
+    }
+
+    // A borrowed table: the engines only read the input columns, so they can
+    // point straight at the caller's, and the results go to the caller's buffers
+    ProcessTable t;
+    int *zeros = workload->priority == NULL || workload->queue == NULL ? xcalloc((size_t)(n > 0 ? n : 1), sizeof(int)) : NULL;
+    SimTime *no_times = workload->deadline == NULL || workload->period == NULL ?
+                        xcalloc((size_t)(n > 0 ? n : 1), sizeof(SimTime)) : NULL;
+    table_init(&t);
+    t.count = n;
+    t.capacity = n;
+    t.shared = 1;
+    t.arrival_time = (SimTime *)workload->arrival_time;
+    t.burst_time = (SimTime *)workload->burst_time;
+    t.priority = workload->priority != NULL ? (int *)workload->priority : zeros;
+    t.queue = workload->queue != NULL ? (int *)workload->queue : zeros;
+    t.deadline = workload->deadline != NULL ? (SimTime *)workload->deadline : no_times;
+    t.period = workload->period != NULL ? (SimTime *)workload->period : no_times;
+    t.pid = grow_array(NULL, (size_t)(n > 0 ? n : 1), sizeof(int));
+    t.remaining_time = grow_array(NULL, (size_t)(n > 0 ? n : 1), sizeof(SimTime));
+    t.completion_time = results->completion_time;
+    t.waiting_time = results->waiting_time;
+    t.turnaround_time = results->turnaround_time;
+    t.response_time = results->response_time;
+    for (int i = 0; i < n; i++) {
+        t.pid[i] = i + 1;
+        t.remaining_time[i] = t.burst_time[i];
+        t.completion_time[i] = 0;
+        t.waiting_time[i] = 0;
+        t.turnaround_time[i] = 0;
+        t.response_time[i] = -1;
+    }
+
+    Gantt chart;
+    Gantt *gantt = results->gantt;
+    if (gantt == NULL && results->segments != NULL) {
+        gantt_init(&chart, results->segments, results->segment_capacity, NULL, NULL);
+        gantt = &chart;
+    }
+    size_t recorded = gantt != NULL ? gantt->total : 0;
+    if (results->stats != NULL)
+        stats_init(results->stats);
+    if (results->metrics != NULL)
+        metrics_init(results->metrics, "");
+
+    if (config->smp.cpus > 1) {
+        CoreStats *usage = results->usage != NULL ? results->usage : xmalloc(sizeof(CoreStats) * config->smp.cpus);
+        results->makespan = run_multicore(&t, config->algorithm, config->quantum, &config->smp, gantt, usage,
+                                          results->stats, results->metrics);
+        if (usage != results->usage)
+            free(usage);
+    } else if (config->algorithm == 7) {
+        // group_by_queue() fills in each queue's range, so work on a copy
+        Queue *queues = grow_array(NULL, (size_t)config->num_queues, sizeof(Queue));
+        int *members = grow_array(NULL, (size_t)(n > 0 ? n : 1), sizeof(int));
+        memcpy(queues, config->queues, sizeof(Queue) * config->num_queues);
+        group_by_queue(&t, queues, config->num_queues, members);
+        results->makespan = run_multilevel(&t, queues, config->num_queues, members, gantt,
+                                           results->stats, results->metrics);
+        free(members);
+        free(queues);
+    } else {
+        gantt_begin(gantt, config->algorithm, 0);
+        if (config->algorithm == 8)
+            results->makespan = run_feedback(&t, &config->feedback, gantt, results->stats, results->metrics);
+        else if (config->algorithm == 9)
+            results->makespan = run_fair(&t, &config->fair, gantt, results->stats, results->metrics);
+        else
+            results->makespan = run_algorithm(&t, config->algorithm, config->quantum, gantt,
+                                              results->stats, results->metrics, config->threads);
+        gantt_end(gantt);
+    }
+    results->segment_count = gantt != NULL ? gantt->total - recorded : 0;
+
+    free(t.pid);
+    free(t.remaining_time);
+    free(zeros);
+    free(no_times);
+    return 0;
+}
@@ -0,0 +1,550 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CPU scheduling simulator library. Every function works only on the
+// memory it is given: there is no global state (beyond the worker pool's
+// per-thread flag) and nothing reads or writes files, so independent runs
+// can go on concurrently from any number of threads. Allocation failures
+// abort(). sched_run() at the bottom is the whole interface most callers
+// need; the rest is exposed for front ends that drive the engines directly.
+
+// Simulated time is 64-bit so long traces with huge gaps or bursts can't overflow
+typedef long long SimTime;
+
+// Process table in structure-of-arrays layout. The fields every scheduling
+// decision reads are kept apart from the results written once per process,
+// so selection scans only pull the hot arrays into cache.
+typedef struct {
+    int count;
+    int capacity;
+    int shared;         // Input columns are borrowed from another table
+
+    // Hot: read on every selection
+    SimTime *arrival_time;
+    SimTime *remaining_time;
+    int *priority;
+    SimTime *deadline;  // Relative to arrival, 0 = none (EDF)
+    SimTime *period;    // Release interval of a periodic task, 0 = one-shot (RM)
+
+    // Cold: read at dispatch or written at completion
+    int *pid;
+    SimTime *burst_time;
+    SimTime *completion_time;
+    SimTime *waiting_time;
+    SimTime *turnaround_time;
+    SimTime *response_time; // Arrival to first dispatch, -1 until it first runs
+    int *queue;         // Multilevel queue the process is assigned to
+} ProcessTable;
+
+typedef struct {
+    int algorithm;      // 1=FCFS, 2=SJF, 3=RR, 4=Priority
+    int quantum;        // For RR
+    int first;          // Start of this queue's range in the member list
+    int process_count;  // Number of processes in this queue
+} Queue;
+
+// Set of arrived, unfinished processes. The engine pushes a process when it
+// arrives or is preempted and pops whenever the CPU needs a new one.
+typedef struct ReadyQueue {
+    void (*push)(struct ReadyQueue *rq, int idx);
+    int (*pop)(struct ReadyQueue *rq);                          // -1 when nothing is ready
+    int (*before)(const ProcessTable *t, int a, int b);         // Selection order
+    const ProcessTable *table;
+    int *items;
+    int count;
+    int capacity;
+    int head;           // Oldest entry (FIFO ring)
+    long long steps;    // Heap sift steps, for metrics
+} ReadyQueue;
+
+// One run-length segment of the Gantt chart: pid ran over [start, end)
+typedef struct {
+    int pid;
+    SimTime start;
+    SimTime end;
+} GanttSegment;
+
+// Gantt chart collected into a caller-provided buffer. A run begins with a
+// marker segment: pid 0, start = algorithm menu number, end = queue level
+// or CPU. When the buffer fills, flush (if set) is called to drain or grow
+// it; without one the first `capacity` segments are kept and the rest only
+// counted. flush is also called with end = 1 once a run's chart is complete.
+typedef struct Gantt {
+    GanttSegment *segments;
+    size_t capacity;
+    size_t count;       // Segments in the buffer
+    size_t total;       // Segments recorded, kept or not
+    void (*flush)(struct Gantt *g, int end);
+    void *ctx;          // For flush
+    GanttSegment last;  // Pending segment, still open for merging
+    int open;
+} Gantt;
+
+// Log-linear histogram in the style of HDR Histogram. Values below
+// HIST_SUB_COUNT get a bucket each; above that every power of two is split
+// into HIST_SUB_COUNT / 2 buckets, so any value is known to within 1/64 of
+// itself. The bucket count is fixed whatever the number or size of samples,
+// and histograms with the same layout merge by adding counts.
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * (HIST_SUB_COUNT / 2))
+
+typedef struct {
+    long long count;
+    double sum;
+    SimTime min;
+    SimTime max;
+    long long buckets[HIST_BUCKETS];
+} Histogram;
+
+// Completion-time distributions of one run, updated as processes finish.
+// Lateness (completion minus absolute deadline) can have either sign, so
+// processes with a deadline go into one histogram of how early the on-time
+// ones finished and one of how late the rest did; late.count is the misses.
+typedef struct {
+    Histogram waiting;
+    Histogram turnaround;
+    Histogram response;     // From arrival to first dispatch
+    Histogram early;        // Deadline minus completion, deadline met
+    Histogram late;         // Completion minus deadline, deadline missed
+} Stats;
+
+// Scheduling work done by one run, for finding where the time goes.
+// Building with -DSCHED_NO_METRICS compiles the counting out: METRIC()
+// statements are still type-checked but become dead code.
+#ifdef SCHED_NO_METRICS
+#define METRIC(...) do { if (0) { __VA_ARGS__; } } while (0)
+#else
+#define METRIC(...) do { __VA_ARGS__; } while (0)
+#endif
+
+typedef struct {
+    char algorithm[16];         // Empty for an unused entry
+    long long dispatches;       // Scheduling decisions: slices started
+    long long switches;         // Slices that run a different process than the one before
+    long long preemptions;      // Slices that ended with work left
+    long long idle_jumps;       // Times the clock skipped ahead to the next arrival
+    SimTime idle_skipped;       // Idle time covered by those jumps
+    long long queue_pushes;
+    long long queue_pops;
+    long long select_steps;     // Heap sift steps or tree levels walked
+    double simulate_seconds;    // In the engine, including writing its chart
+    double report_seconds;      // Printing results and statistics
+} Metrics;
+
+// Everything the shared event loop needs to know about one algorithm
+typedef struct {
+    ReadyQueue *ready;
+    SimTime quantum;    // > 0: preempt after this many units (RR)
+    int preemptive;     // Re-select whenever a new process arrives (SRT)
+    Gantt *gantt;       // Where slices are recorded, NULL = nowhere
+    Stats *stats;       // Where completions are recorded, NULL = nowhere
+    struct Checkpointer *checkpoint;    // Full-table runs only, NULL = none
+    Metrics *metrics;   // Where counters are added, NULL = nowhere
+    int threads;        // FCFS scan: most worker threads to start, <= 1 = the calling thread only
+    long long dispatches;   // Slices run so far, counted by the engine
+} Policy;
+
+// Multilevel feedback queue: one FIFO per level, linked through next[] so the
+// levels reference the process table instead of holding copies. Bit l of
+// nonempty is set while level l has a process, so the highest non-empty level
+// is the lowest set bit and dispatch is O(1) however many levels or processes.
+#define MLFQ_MAX_LEVELS 64
+
+typedef struct {
+    int num_levels;
+    SimTime quantum[MLFQ_MAX_LEVELS];   // 0 = run to completion (last level only)
+    SimTime boost;                      // Move everything back to level 0 this often, 0 = never
+} FeedbackConfig;
+
+typedef struct {
+    const FeedbackConfig *config;
+    Gantt *gantt;
+    Stats *stats;
+    struct Checkpointer *checkpoint;    // NULL = none
+    Metrics *metrics;                   // NULL = nowhere
+    uint64_t nonempty;
+    int head[MLFQ_MAX_LEVELS];
+    int tail[MLFQ_MAX_LEVELS];
+    int *next;              // Next process in the same level, -1 at the tail
+    SimTime *used;          // Time used of the current level's quantum
+    int *epoch;             // Boost epoch `used` was recorded in; older counts as 0
+    int boosts;             // Current boost epoch
+    long long dispatches;   // Slices run so far
+} FeedbackQueue;
+
+typedef struct {
+    SimTime latency;            // Target latency: each runnable process runs once per period
+    SimTime min_granularity;    // Shortest slice; the period stretches to give everyone one
+} FairConfig;
+
+// Completely fair queue: runnable processes in a red-black tree keyed by
+// virtual runtime, as in CFS. Nodes are process indices and slot `nil` is
+// the shared black sentinel, so the textbook insert and delete fixups apply
+// unchanged. The leftmost node is cached: selection is O(1), insertion and
+// removal O(log n).
+typedef struct {
+    const FairConfig *config;
+    Gantt *gantt;
+    Stats *stats;
+    struct Checkpointer *checkpoint;    // NULL = none
+    Metrics *metrics;                   // NULL = nowhere
+    double *vruntime;       // Run time scaled by NICE_0_WEIGHT / weight
+    int *weight;
+    int *left;
+    int *right;
+    int *parent;
+    char *red;
+    int nil;                // Sentinel slot, one past the last process
+    int root;
+    int leftmost;
+    int count;
+    long long total_weight; // Of every process in the tree
+    double min_vruntime;    // Never decreases; new arrivals start here
+    long long dispatches;   // Slices run so far
+    long long steps;        // Tree levels walked by inserts and fixups, for metrics
+} FairQueue;
+
+// A checkpoint is a single-CPU run stopped between two slices: the clock,
+// how many processes have arrived and finished, every process's remaining
+// and response time (and completion once finished), and the ready queue in
+// dispatch order with each entry's MLFQ level and used quantum or CFS
+// vruntime. Resuming restores that and carries on, so nothing before the
+// checkpoint is simulated again. A checkpoint also fits a longer trace as
+// long as the extra processes come after the original ones and arrive no
+// earlier than the checkpoint's clock. One taken as the final arrivals cut
+// a slice short holds the preempted process back as the last ready entry,
+// to be queued behind those arrivals as the uninterrupted run does.
+typedef struct {
+    uint64_t settings;      // Hash of the algorithm and its parameters
+    uint64_t fingerprint;   // Hash of the covered processes' arrival, burst and priority
+    int64_t time;
+    int64_t next_boost;     // MLFQ
+    int64_t dispatches;
+    double min_vruntime;    // CFS
+    int32_t count;          // Processes covered
+    int32_t next;           // How many of them have arrived, in arrival order
+    int32_t completed;
+    int32_t ready_count;
+    int32_t held;           // 1 if the last ready entry goes back in after the arrivals at time
+} CheckpointHeader;
+
+typedef struct {
+    int32_t idx;
+    int32_t level;          // MLFQ
+    int64_t used;           // MLFQ: time used of the level's quantum
+    double vruntime;        // CFS
+} ReadyEntry;
+
+typedef struct {
+    CheckpointHeader header;
+    SimTime *remaining;
+    SimTime *response;
+    SimTime *completion;
+    ReadyEntry *ready;
+} Checkpoint;
+
+// What one run does about checkpoints
+typedef struct Checkpointer {
+    // Stores a checkpoint, setting failed if it couldn't; NULL = never take one
+    void (*save)(struct Checkpointer *cp, const ProcessTable *t, const CheckpointHeader *h,
+                 const ReadyEntry ready[]);
+    void *ctx;                  // For save, e.g. where to write
+    long long every;            // Also after every this many slices, 0 = never
+    const Checkpoint *resume;   // Start from here instead of time 0, NULL = don't
+    uint64_t settings;
+    uint64_t fingerprint;       // Of the whole table
+    long long due;              // Slice count of the next periodic checkpoint
+    int arrivals_saved;         // Written the one taken before the final arrivals
+    int saved;                  // Checkpoints stored this run
+    int failed;
+} Checkpointer;
+
+// xoshiro256** seeded through splitmix64. Every replication derives its own
+// stream from (seed, replication), so results don't depend on which worker
+// thread happened to run it.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+enum { ARRIVAL_POISSON, ARRIVAL_BURSTY };
+enum { BURST_EXPONENTIAL, BURST_PARETO, BURST_BIMODAL };
+
+typedef struct {
+    int count;              // Processes per workload
+    int arrival_kind;
+    double arrival_mean;    // Mean time between arrivals
+    double batch_mean;      // Bursty: mean arrivals per batch
+    int burst_kind;
+    double burst_a;         // Exponential: mean. Pareto: alpha. Bimodal: short mean.
+    double burst_b;         // Pareto: minimum. Bimodal: long mean.
+    double burst_p;         // Bimodal: probability of a long burst
+    int priorities;         // Priorities drawn uniformly from [0, priorities)
+    int queues;             // Queues drawn uniformly from [0, queues)
+    double utilization;     // > 0: draw periodic tasks with this total utilization instead
+    SimTime period_min;     // Periodic: periods are log-uniform in [period_min, period_max]
+    SimTime period_max;
+    int devices;            // > 0: processes also block on I/O devices 0..devices-1
+    int io_requests;        // I/O: requests per process, splitting its CPU demand
+    double io_service;      // I/O: mean service time of a request
+    uint64_t seed;
+} GeneratorConfig;
+
+// Arrival process of one generated workload, drawn one process at a time.
+// Poisson arrivals have exponential gaps; bursty arrivals come in batches of
+// geometric size with exponential gaps between batches, at the same mean rate.
+// Periodic tasks all start at time 0 and split the utilization by UUniFast,
+// which gives every split of the total the same chance. A task whose share
+// can't fill one time unit at its period gets a longer period instead.
+typedef struct {
+    const GeneratorConfig *config;
+    Rng rng;
+    double clock;
+    int batch_left;     // Bursty: arrivals left in the current batch
+    long long left;     // generator_read: processes left to draw
+    long long drawn;    // Periodic: tasks drawn so far
+    double utilization_left;    // Periodic: still to share among the other tasks
+} Generator;
+
+enum { PLACE_ROUND_ROBIN, PLACE_LEAST_LOADED, PLACE_RANDOM };
+enum { BALANCE_NONE, BALANCE_STEAL, BALANCE_PERIODIC };
+
+typedef struct {
+    int cpus;
+    int placement;          // Which core an arriving process is queued on
+    int balance;            // How queued work moves between cores
+    SimTime balance_period; // BALANCE_PERIODIC: rebalance this often
+    uint64_t seed;          // PLACE_RANDOM
+} SmpConfig;
+
+typedef struct {
+    SimTime busy;
+    long long slices;
+    long long migrations;   // Processes moved onto this core from another one
+} CoreStats;
+
+// Processes that block on I/O. Process i's bursts are steps[first[i]] up to
+// steps[first[i + 1]]: CPU bursts alternating with requests to a device,
+// starting and ending with a CPU burst, with the CPU bursts adding up to its
+// burst_time. A process with no steps, or past `processes`, is one CPU burst
+// of burst_time, so only the ones that do I/O take any room. Each device
+// serves one request at a time and queues the rest in FIFO order.
+#define IO_MAX_DEVICES 16
+
+typedef struct {
+    int device;         // -1 for a CPU burst, else the device serving the request
+    SimTime time;       // CPU time, or the request's service time
+} IoStep;
+
+typedef struct {
+    int devices;
+    int processes;      // Processes first[] covers
+    int capacity;       // Of first[]
+    int *first;         // processes + 1 offsets into steps
+    IoStep *steps;
+    int step_count;
+    int step_capacity;
+} IoWorkload;
+
+typedef struct {
+    SimTime busy;
+    long long requests;
+    SimTime queued;     // Time requests spent waiting behind others
+    int max_queue;      // Most requests at the device at once, in service included
+} DeviceStats;
+
+typedef struct {
+    SimTime cpu_busy;
+    DeviceStats devices[IO_MAX_DEVICES];
+} IoUsage;
+
+// A streamed run holds only the processes that have arrived and not yet
+// finished, plus the next one to arrive, in a table used as a pool of slots.
+// A process takes a free slot when it is read and hands it back once its
+// completion has gone into the statistics, so memory follows the number of
+// active processes instead of the length of the input.
+enum { STREAM_END = -1, STREAM_ERROR = -2 };
+
+typedef struct {
+    ProcessTable table;
+    int *free_slots;
+    int free_count;
+    int active;             // Slots in use, the next arrival included
+    int peak;
+    long long admitted;     // Processes read so far
+    SimTime last_arrival;
+    SimTime out_of_order;   // Arrival of the process that broke arrival order, -1 = none
+    // Fills arrival, burst, priority and queue of slot i with the next
+    // process, and deadline if it has one; periods are ignored. Returns 1,
+    // 0 at the end of the input or -1 if it is bad.
+    int (*read)(void *source, ProcessTable *t, int i);
+    void *source;
+    // Called as each process finishes, before its slot is reused; NULL = not at all
+    void (*finished)(void *ctx, const ProcessTable *t, int idx, int active);
+    void *ctx;
+} Stream;
+
+// ---------------------------------------------------------------------------
+// Library interface
+// ---------------------------------------------------------------------------
+
+// A workload in caller memory, one entry per process. Pids are positions
+// from 1. priority, queue, deadline and period may be NULL for all 0. Each
+// entry runs once: periods only rank processes for RM, so expand periodic
+// tasks into jobs with release_jobs() first to simulate them over time.
+typedef struct {
+    int count;
+    const SimTime *arrival_time;
+    const SimTime *burst_time;
+    const int *priority;
+    const int *queue;
+    const SimTime *deadline;
+    const SimTime *period;
+} SchedWorkload;
+
+typedef struct {
+    int algorithm;          // 1=FCFS, 2=SJF, 3=RR, 4=Priority, 5=SRT, 7=Multilevel queue, 8=MLFQ, 9=CFS,
+                            // 12=EDF, 13=RM
+    int quantum;            // RR
+    const Queue *queues;    // Multilevel queue: algorithm and quantum of each, highest first
+    int num_queues;
+    FeedbackConfig feedback;    // MLFQ
+    FairConfig fair;            // CFS
+    SmpConfig smp;          // cpus > 1 runs algorithm 1-5, 12 or 13 on that many cores; 0 = one CPU
+    int threads;            // FCFS may split a long run across this many threads; 0 = the calling thread only
+} SchedConfig;
+
+// Where sched_run puts its results, all in caller memory. The four time
+// columns are required and have one entry per process; everything else is
+// optional.
+typedef struct {
+    SimTime *completion_time;
+    SimTime *waiting_time;
+    SimTime *turnaround_time;
+    SimTime *response_time;
+    GanttSegment *segments;     // Chart, as described at Gantt; NULL = don't record one
+    size_t segment_capacity;
+    size_t segment_count;       // Set to the whole chart's length, even past segment_capacity
+    Gantt *gantt;               // Record into this chart instead of segments, e.g. one with a flush; NULL = none
+    CoreStats *usage;           // Multi-core: smp.cpus entries, NULL = none
+    Stats *stats;               // NULL = none
+    Metrics *metrics;           // NULL = none
+    SimTime makespan;           // Set to the time the last process finished
+} SchedResults;
+
+// Simulate config over workload into results. Reentrant: calls share nothing
+// but the inputs they are given. Returns 0, or -1 if the workload or config
+// is invalid.
+int sched_run(const SchedWorkload *workload, const SchedConfig *config, SchedResults *results);
+
+// ---------------------------------------------------------------------------
+// Building blocks
+// ---------------------------------------------------------------------------
+
+void table_init(ProcessTable *t);
+void table_reserve(ProcessTable *t, int capacity);
+int table_add(ProcessTable *t, SimTime arrival_time, SimTime burst_time, int priority);
+void table_fork(ProcessTable *dst, const ProcessTable *src);
+void table_free(ProcessTable *t);
+
+void histogram_init(Histogram *h);
+void histogram_add(Histogram *h, SimTime value);
+void histogram_merge(Histogram *into, const Histogram *from);
+double histogram_mean(const Histogram *h);
+SimTime histogram_percentile(const Histogram *h, double p);
+void stats_init(Stats *s);
+void stats_record(Stats *s, const ProcessTable *t, int idx);
+void stats_merge(Stats *into, const Stats *from);
+double lateness_mean(const Stats *s);
+SimTime lateness_percentile(const Stats *s, double p);
+
+double wall_clock(void);
+void metrics_init(Metrics *metrics, const char *algorithm);
+void metrics_add(Metrics *into, const Metrics *from);
+
+int cpu_count(void);
+void parallel_for(int count, void (*fn)(void *ctx, int i), void *ctx);
+
+void gantt_init(Gantt *g, GanttSegment segments[], size_t capacity,
+                void (*flush)(Gantt *g, int end), void *ctx);
+void gantt_begin(Gantt *g, int algorithm, int level);
+void gantt_record(Gantt *g, int pid, SimTime start, SimTime end);
+void gantt_splice(Gantt *g, const GanttSegment segments[], size_t count);
+void gantt_end(Gantt *g);
+
+void ready_init(ReadyQueue *rq, const ProcessTable *t, int capacity,
+                void (*push)(ReadyQueue *, int), int (*pop)(ReadyQueue *),
+                int (*before)(const ProcessTable *, int, int));
+void ready_free(ReadyQueue *rq);
+void ring_push(ReadyQueue *rq, int idx);
+int ring_pop(ReadyQueue *rq);
+void heap_push(ReadyQueue *rq, int idx);
+int heap_pop(ReadyQueue *rq);
+void feedback_init(FeedbackQueue *fq, int capacity, const FeedbackConfig *config, Gantt *gantt);
+void feedback_free(FeedbackQueue *fq);
+void fair_init(FairQueue *fq, int capacity, const FairConfig *config, Gantt *gantt);
+void fair_free(FairQueue *fq);
+int arrival_before(const ProcessTable *t, int a, int b);
+int remaining_before(const ProcessTable *t, int a, int b);
+int priority_before(const ProcessTable *t, int a, int b);
+int deadline_before(const ProcessTable *t, int a, int b);
+int period_before(const ProcessTable *t, int a, int b);
+
+uint64_t checkpoint_settings(int algorithm, int quantum, const FeedbackConfig *feedback, const FairConfig *fair);
+uint64_t checkpoint_fingerprint(const ProcessTable *t, int count);
+
+void sort_by_arrival(const ProcessTable *t, int order[], int n);
+SimTime effective_arrival(const ProcessTable *t, int idx, SimTime start_time);
+SimTime simulate(ProcessTable *t, const int order[], int n, SimTime start_time, Policy *policy);
+SimTime simulate_all(ProcessTable *t, Policy *policy);
+SimTime simulate_feedback(ProcessTable *t, FeedbackQueue *fq);
+SimTime simulate_fair(ProcessTable *t, FairQueue *fq);
+
+void policy_init(Policy *policy, ReadyQueue *rq, const ProcessTable *t, int capacity,
+                 int algorithm, int quantum, Gantt *gantt);
+SimTime run_algorithm(ProcessTable *t, int algorithm, int quantum, Gantt *gantt, Stats *stats, Metrics *metrics,
+                      int threads);
+SimTime run_feedback(ProcessTable *t, const FeedbackConfig *config, Gantt *gantt, Stats *stats, Metrics *metrics);
+SimTime run_fair(ProcessTable *t, const FairConfig *config, Gantt *gantt, Stats *stats, Metrics *metrics);
+SimTime run_resumable(ProcessTable *t, int algorithm, int quantum, const FeedbackConfig *feedback,
+                      const FairConfig *fair, Checkpointer *cp, Gantt *gantt, Stats *stats, Metrics *metrics);
+void group_by_queue(const ProcessTable *t, Queue queues[], int num_queues, int members[]);
+SimTime run_queue(ProcessTable *t, const Queue *queue, int level, const int members[],
+                  SimTime start_time, Gantt *gantt, Stats *stats, Metrics *metrics);
+SimTime run_multilevel(ProcessTable *t, const Queue queues[], int num_queues, const int members[],
+                       Gantt *gantt, Stats *stats, Metrics *metrics);
+
+double utilization(const ProcessTable *t, int *tasks);
+double rm_bound(int tasks);
+SimTime hyperperiod(const ProcessTable *t, SimTime limit);
+int release_jobs(ProcessTable *t, SimTime horizon);
+
+void rng_seed(Rng *rng, uint64_t seed, uint64_t stream);
+uint64_t rng_next(Rng *rng);
+double rng_uniform(Rng *rng);
+double rng_exponential(Rng *rng, double mean);
+void generator_init(Generator *gen, const GeneratorConfig *g, uint64_t stream);
+void generator_next(Generator *gen, ProcessTable *t, int i);
+int generator_read(void *source, ProcessTable *t, int i);
+void generate_workload(ProcessTable *t, const GeneratorConfig *g, uint64_t stream);
+
+SimTime run_multicore(ProcessTable *t, int algorithm, int quantum, const SmpConfig *config,
+                      Gantt *gantt, CoreStats usage[], Stats *stats, Metrics *metrics);
+
+void io_init(IoWorkload *io, int devices);
+void io_free(IoWorkload *io);
+void io_set(IoWorkload *io, int i, const IoStep steps[], int count);
+int io_count(const IoWorkload *io, int i);
+void generate_io(IoWorkload *io, const ProcessTable *t, const GeneratorConfig *g, uint64_t stream);
+SimTime simulate_io(ProcessTable *t, const IoWorkload *io, Policy *policy, IoUsage *usage);
+SimTime run_io(ProcessTable *t, const IoWorkload *io, int algorithm, int quantum, Gantt *gantt,
+               Stats *stats, Metrics *metrics, IoUsage *usage);
+
+void stream_init(Stream *s, int (*read)(void *source, ProcessTable *t, int i), void *source);
+void stream_free(Stream *s);
+SimTime simulate_stream(Stream *s, Policy *policy);
+
+#endif
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "sched.h"
+
+// Self-checks of the simulator library, run by `make check`: sched_run for
+// every algorithm, and checkpoints resumed against uninterrupted runs. The
+// trace and results file round trips go through the sched program and live
+// in the Makefile.
+
+static int failures;
+
+static void check(int ok, const char *format, ...) {
+    if (ok)
+        return;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "FAIL: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    failures++;
+}
+
+// A seeded workload with priorities, queues and deadlines to rank by
+static void make_workload(ProcessTable *t, int count, uint64_t seed) {
+    GeneratorConfig g = { count, ARRIVAL_POISSON, 10, 1, BURST_EXPONENTIAL, 8, 0, 0, 8, 3, 0, 0, 0, 0, 0, 0, seed };
+    table_init(t);
+    generate_workload(t, &g, 0);
+    for (int i = 0; i < t->count; i++) {
+        t->deadline[i] = t->burst_time[i] * (1 + i % 4);
+        t->period[i] = 20 * (1 + i % 5);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// sched_run
+// ---------------------------------------------------------------------------
+
+static const Queue check_queues[] = { { 3, 4, 0, 0 }, { 2, 0, 0, 0 }, { 1, 0, 0, 0 } };
+
+// Run config over t through sched_run and check that every process ran its
+// whole burst once it arrived, and that the chart adds up to the bursts. A
+// multilevel queue counts times from when a process's queue got the CPU.
+static void check_run(const ProcessTable *t, const SchedConfig *config, const char *name) {
+    int n = t->count;
+    size_t capacity = 64 * (size_t)n + 64;
+    SimTime *completion = malloc(sizeof(SimTime) * n);
+    SimTime *waiting = malloc(sizeof(SimTime) * n);
+    SimTime *turnaround = malloc(sizeof(SimTime) * n);
+    SimTime *response = malloc(sizeof(SimTime) * n);
+    GanttSegment *segments = malloc(sizeof(GanttSegment) * capacity);
+    CoreStats usage[4];
+    Stats stats;
+    SchedWorkload workload = { n, t->arrival_time, t->burst_time, t->priority, t->queue, t->deadline, t->period };
+    SchedResults results = { completion, waiting, turnaround, response, segments, capacity, 0, NULL,
+                             config->smp.cpus > 1 ? usage : NULL, &stats, NULL, 0 };
+
+    int status = sched_run(&workload, config, &results);
+    check(status == 0, "%s: sched_run returned %d", name, status);
+    if (status == 0) {
+        SimTime bursts = 0, charted = 0, last = 0;
+        int bad = 0;
+        for (int i = 0; i < n; i++) {
+            SimTime since_arrival = completion[i] - t->arrival_time[i];
+            bursts += t->burst_time[i];
+            if (completion[i] > last)
+                last = completion[i];
+            if (bad == 0 && (completion[i] < t->arrival_time[i] + t->burst_time[i] ||
+                             (config->algorithm == 7 ? turnaround[i] > since_arrival : turnaround[i] != since_arrival) ||
+                             waiting[i] != turnaround[i] - t->burst_time[i] ||
+                             response[i] < 0 || response[i] > waiting[i]))
+                bad = i + 1;
+        }
+        check(bad == 0, "%s: process %d has inconsistent times", name, bad);
+        check(results.segment_count <= capacity, "%s: chart overflowed its buffer", name);
+        for (size_t s = 0; s < results.segment_count && s < capacity; s++) {
+            if (segments[s].pid > 0)
+                charted += segments[s].end - segments[s].start;
+        }
+        check(charted == bursts, "%s: chart covers %lld of %lld units", name, charted, bursts);
+        check(results.makespan == last, "%s: makespan %lld, last completion %lld", name,
+              results.makespan, last);
+        check(stats.waiting.count == (long long)n, "%s: %lld of %d completions recorded", name,
+              (long long)stats.waiting.count, n);
+    }
+
+    free(completion);
+    free(waiting);
+    free(turnaround);
+    free(response);
+    free(segments);
+}
+
+static void check_algorithms(void) {
+    static const int algorithms[] = { 1, 2, 3, 4, 5, 7, 8, 9, 12, 13 };
+    static const int smp_algorithms[] = { 1, 2, 3, 4, 5, 12, 13 };
+    ProcessTable t;
+    make_workload(&t, 2000, 7);
+
+    for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+        SchedConfig config = { 0 };
+        char name[32];
+        config.algorithm = algorithms[a];
+        config.quantum = 4;
+        config.queues = check_queues;
+        config.num_queues = 3;
+        config.feedback = (FeedbackConfig){ 3, { 4, 8, 16 }, 100 };
+        config.fair = (FairConfig){ 24, 3 };
+        snprintf(name, sizeof(name), "algorithm %d", config.algorithm);
+        check_run(&t, &config, name);
+    }
+    for (size_t a = 0; a < sizeof(smp_algorithms) / sizeof(smp_algorithms[0]); a++) {
+        SchedConfig config = { 0 };
+        char name[32];
+        config.algorithm = smp_algorithms[a];
+        config.quantum = 4;
+        config.smp = (SmpConfig){ 4, PLACE_LEAST_LOADED, BALANCE_STEAL, 0, 1 };
+        snprintf(name, sizeof(name), "algorithm %d on 4 CPUs", config.algorithm);
+        check_run(&t, &config, name);
+    }
+
+    SchedConfig bad = { 0 };
+    SchedWorkload workload = { t.count, t.arrival_time, t.burst_time, NULL, NULL, NULL, NULL };
+    SchedResults results = { t.completion_time, t.waiting_time, t.turnaround_time, t.response_time,
+                             NULL, 0, 0, NULL, NULL, NULL, NULL, 0 };
+    bad.algorithm = 6;
+    check(sched_run(&workload, &bad, &results) == -1, "sched_run accepted algorithm 6");
+    table_free(&t);
+}
+
+// FCFS split across threads has to match the serial run exactly
+static void check_threads(void) {
+    ProcessTable t;
+    make_workload(&t, 300000, 11);
+    int n = t.count;
+    SimTime *serial = malloc(sizeof(SimTime) * n);
+    SchedConfig config = { 0 };
+    SchedWorkload workload = { n, t.arrival_time, t.burst_time, NULL, NULL, NULL, NULL };
+    SchedResults results = { t.completion_time, t.waiting_time, t.turnaround_time, t.response_time,
+                             NULL, 0, 0, NULL, NULL, NULL, NULL, 0 };
+
+    config.algorithm = 1;
+    check(sched_run(&workload, &config, &results) == 0, "serial FCFS failed");
+    memcpy(serial, t.completion_time, sizeof(SimTime) * n);
+    config.threads = 4;
+    check(sched_run(&workload, &config, &results) == 0, "threaded FCFS failed");
+    check(memcmp(serial, t.completion_time, sizeof(SimTime) * n) == 0, "threaded FCFS differs from serial");
+
+    free(serial);
+    table_free(&t);
+}
+
+// ---------------------------------------------------------------------------
+// Checkpoints
+// ---------------------------------------------------------------------------
+
+// Keeps the latest checkpoint in memory
+static void keep_checkpoint(Checkpointer *cp, const ProcessTable *t, const CheckpointHeader *h,
+                            const ReadyEntry ready[]) {
+    Checkpoint *kept = cp->ctx;
+    size_t n = (size_t)h->count;
+
+    kept->header = *h;
+    kept->remaining = realloc(kept->remaining, sizeof(SimTime) * (n > 0 ? n : 1));
+    kept->response = realloc(kept->response, sizeof(SimTime) * (n > 0 ? n : 1));
+    kept->completion = realloc(kept->completion, sizeof(SimTime) * (n > 0 ? n : 1));
+    kept->ready = realloc(kept->ready, sizeof(ReadyEntry) * (h->ready_count > 0 ? (size_t)h->ready_count : 1));
+    memcpy(kept->remaining, t->remaining_time, sizeof(SimTime) * n);
+    memcpy(kept->response, t->response_time, sizeof(SimTime) * n);
+    memcpy(kept->completion, t->completion_time, sizeof(SimTime) * n);
+    memcpy(kept->ready, ready, sizeof(ReadyEntry) * (size_t)h->ready_count);
+}
+
+// Take checkpoints of one run, then resume from the last one and compare
+// with the run that wasn't interrupted
+static void check_resume(ProcessTable *t, int algorithm, long long every, uint64_t seed) {
+    static const FeedbackConfig feedback = { 3, { 4, 8, 16 }, 100 };
+    static const FairConfig fair = { 24, 3 };
+    int n = t->count;
+    SimTime *full = malloc(sizeof(SimTime) * n);
+    SimTime *response = malloc(sizeof(SimTime) * n);
+    Checkpoint kept = { { 0 }, NULL, NULL, NULL, NULL };
+    Checkpointer cp = { keep_checkpoint, &kept, every, NULL, 0, 0, 0, 0, 0, 0 };
+    Stats stats;
+
+    stats_init(&stats);
+    run_resumable(t, algorithm, 3, &feedback, &fair, &cp, NULL, &stats, NULL);
+    memcpy(full, t->completion_time, sizeof(SimTime) * n);
+    memcpy(response, t->response_time, sizeof(SimTime) * n);
+    check(cp.saved > 0, "algorithm %d, seed %llu: no checkpoint taken", algorithm, (unsigned long long)seed);
+
+    if (cp.saved > 0) {
+        Checkpointer again = { NULL, NULL, 0, &kept, 0, 0, 0, 0, 0, 0 };
+        stats_init(&stats);
+        run_resumable(t, algorithm, 3, &feedback, &fair, &again, NULL, &stats, NULL);
+        check(memcmp(full, t->completion_time, sizeof(SimTime) * n) == 0 &&
+              memcmp(response, t->response_time, sizeof(SimTime) * n) == 0,
+              "algorithm %d, seed %llu: resuming after %lld slices changed the results", algorithm,
+              (unsigned long long)seed, (long long)kept.header.dispatches);
+        check(stats.waiting.count == (long long)n, "algorithm %d, seed %llu: resumed run recorded %lld of %d",
+              algorithm, (unsigned long long)seed, (long long)stats.waiting.count, n);
+    }
+
+    free(kept.remaining);
+    free(kept.response);
+    free(kept.completion);
+    free(kept.ready);
+    free(full);
+    free(response);
+}
+
+static void check_checkpoints(void) {
+    static const int algorithms[] = { 1, 2, 3, 4, 5, 8, 9 };
+
+    for (uint64_t seed = 1; seed <= 10; seed++) {
+        ProcessTable t;
+        make_workload(&t, 3000, seed);
+        for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+            check_resume(&t, algorithms[a], 0, seed);
+            check_resume(&t, algorithms[a], 997, seed);
+        }
+        table_free(&t);
+    }
+}
+
+int main(void) {
+    check_algorithms();
+    check_threads();
+    check_checkpoints();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("Library checks passed\n");
+    return 0;
+}